@@ -0,0 +1,149 @@
+/**
+ * @file batch_bench.c
+ * @brief Benchmark of a collection tick's file reads: one pread() chain per file against one io_uring batch.
+ *
+ * Every tick reads the same set of procfs files. The pread() path goes through the reader cache exactly as the
+ * collectors do; the io_uring path prefetches the whole set in one batch and then takes each file out of the reader
+ * cache, which serves it from the completed buffer. Read system calls are counted with the syscr field of
+ * /proc/self/io, which io_uring reads do not go through; io_uring_enter() calls are counted separately.
+ *
+ * Usage: batch_bench [ticks]
+ *
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "batch_reader.h"
+#include "reader_cache.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_TICKS 5000 /**< Ticks per mode when no count is given. */
+
+static const char* tick_files[] = {
+    "/proc/stat",   "/proc/meminfo", "/proc/net/dev",     "/proc/diskstats",
+    "/proc/vmstat", "/proc/loadavg", "/proc/pressure/cpu", "/proc/uptime",
+}; /**< Files read in every tick. */
+
+#define NUM_FILES (sizeof(tick_files) / sizeof(tick_files[0])) /**< Number of files read per tick. */
+
+/**
+ * @brief Structure to hold the results of one mode.
+ */
+typedef struct
+{
+    double mean_us;       /**< Mean tick latency. */
+    double p99_us;        /**< 99th percentile tick latency. */
+    double read_syscalls; /**< read()/pread() calls per tick. */
+    double enter_calls;   /**< io_uring_enter() calls per tick. */
+} BenchResult;
+
+/**
+ * @brief Retrieves the current CLOCK_MONOTONIC time in microseconds.
+ */
+static double now_us(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1e6 + (double)time.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Retrieves the number of read system calls made by this process so far.
+ *
+ * The read of /proc/self/io itself is counted by the next call, so a before/after pair includes one extra call.
+ */
+static unsigned long long read_syscalls(void)
+{
+    char buffer[512];
+    int fd = open("/proc/self/io", O_RDONLY);
+    ssize_t n = fd >= 0 ? read(fd, buffer, sizeof(buffer) - 1) : -1;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    if (n <= 0)
+    {
+        return 0;
+    }
+    buffer[n] = '\0';
+    const char* syscr = strstr(buffer, "syscr:");
+    return syscr != NULL ? strtoull(syscr + 6, NULL, 10) : 0;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Runs a number of ticks, reading every file once per tick.
+ */
+static BenchResult run_ticks(int ticks, bool batched, char* buffers[], size_t capacities[])
+{
+    double* latencies = malloc((size_t)ticks * sizeof(double));
+    unsigned long long syscalls_before = read_syscalls();
+    unsigned long long enters_before = batch_reader_enter_calls();
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        double start = now_us();
+        if (batched)
+        {
+            batch_reader_prefetch(tick_files, NUM_FILES);
+        }
+        for (size_t i = 0; i < NUM_FILES; i++)
+        {
+            reader_read_all(tick_files[i], &buffers[i], &capacities[i]);
+        }
+        latencies[tick] = now_us() - start;
+    }
+
+    BenchResult result = {0};
+    result.read_syscalls = (double)(read_syscalls() - syscalls_before - 1) / ticks;
+    result.enter_calls = (double)(batch_reader_enter_calls() - enters_before) / ticks;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        result.mean_us += latencies[tick] / ticks;
+    }
+    qsort(latencies, (size_t)ticks, sizeof(double), compare_doubles);
+    result.p99_us = latencies[(size_t)ticks * 99 / 100];
+    free(latencies);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    char* buffers[NUM_FILES] = {NULL};
+    size_t capacities[NUM_FILES] = {0};
+    int ticks = argc > 1 ? atoi(argv[1]) : DEFAULT_TICKS;
+    if (ticks <= 0)
+    {
+        ticks = DEFAULT_TICKS;
+    }
+
+    // Warm the reader cache so both modes run with open descriptors
+    run_ticks(10, false, buffers, capacities);
+    BenchResult pread_result = run_ticks(ticks, false, buffers, capacities);
+
+    printf("%-10s %12s %12s %14s %14s\n", "mode", "mean us", "p99 us", "read calls", "uring enters");
+    printf("%-10s %12.1f %12.1f %14.1f %14.1f\n", "pread", pread_result.mean_us, pread_result.p99_us,
+           pread_result.read_syscalls, pread_result.enter_calls);
+
+    if (batch_reader_init() != 0)
+    {
+        printf("%-10s unavailable\n", "io_uring");
+        return 0;
+    }
+    run_ticks(10, true, buffers, capacities);
+    BenchResult batch_result = run_ticks(ticks, true, buffers, capacities);
+    printf("%-10s %12.1f %12.1f %14.1f %14.1f\n", "io_uring", batch_result.mean_us, batch_result.p99_us,
+           batch_result.read_syscalls, batch_result.enter_calls);
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file net_bench.c
+ * @brief Benchmark of the /proc/net/dev and rtnetlink backends of the per-interface network counters.
+ *
+ * Moves into a private network namespace, creates the requested number of links there (veth pairs by default, or
+ * dummy links where the dummy driver is available), then times get_interface_stats() through each backend: the
+ * /proc/net/dev read and text parse, and the RTM_GETSTATS dump. Both results are compared counter
+ * by counter before timing. The namespace, and every link in it, goes away when the benchmark exits. Needs root (or
+ * CAP_SYS_ADMIN and CAP_NET_ADMIN).
+ *
+ * Usage: net_bench [iterations] [links] [veth|dummy]
+ *
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#define _GNU_SOURCE // unshare() and CLONE_NEWNET
+
+#include "metrics.h"
+#include "netlink_stats.h"
+#include <errno.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/veth.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 200 /**< Reads per backend when no count is given. */
+#define DEFAULT_LINKS 5000     /**< Links created when no count is given. */
+#define REQUEST_SIZE 512       /**< Room for one link creation request. */
+
+/**
+ * @brief Structure to hold a link creation request.
+ */
+typedef struct
+{
+    struct nlmsghdr header;        /**< Netlink header. */
+    struct ifinfomsg info;         /**< Link header, all zero. */
+    char attributes[REQUEST_SIZE]; /**< Nested attributes. */
+} LinkRequest;
+
+/**
+ * @brief Retrieves the current CLOCK_MONOTONIC time in nanoseconds.
+ */
+static double now_ns(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1e9 + (double)time.tv_nsec;
+}
+
+/**
+ * @brief Appends an attribute to a request.
+ *
+ * @return The attribute, to be closed with end_nest() if it nests others.
+ */
+static struct rtattr* add_attribute(LinkRequest* request, unsigned short type, const void* data, size_t length)
+{
+    char* end = request->attributes + NLMSG_ALIGN(request->header.nlmsg_len) - offsetof(LinkRequest, attributes);
+    struct rtattr* attribute = (struct rtattr*)end;
+    attribute->rta_type = type;
+    attribute->rta_len = (unsigned short)RTA_LENGTH(length);
+    if (length > 0)
+    {
+        memcpy(end + RTA_LENGTH(0), data, length);
+    }
+    request->header.nlmsg_len = NLMSG_ALIGN(request->header.nlmsg_len) + RTA_ALIGN(attribute->rta_len);
+    return attribute;
+}
+
+/**
+ * @brief Closes a nested attribute over everything appended since it was opened.
+ */
+static void end_nest(LinkRequest* request, struct rtattr* nest)
+{
+    nest->rta_len = (unsigned short)((char*)request + request->header.nlmsg_len - (char*)nest);
+}
+
+/**
+ * @brief Creates a dummy link, or a veth pair when peer is not NULL, and waits for the kernel's answer.
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+static int create_link(int fd, const char* name, const char* kind, const char* peer)
+{
+    LinkRequest request = {0};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header.nlmsg_type = RTM_NEWLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_EXCL | NLM_F_ACK;
+    request.info.ifi_family = AF_UNSPEC;
+
+    add_attribute(&request, IFLA_IFNAME, name, strlen(name) + 1);
+    struct rtattr* link_info = add_attribute(&request, IFLA_LINKINFO, NULL, 0);
+    add_attribute(&request, IFLA_INFO_KIND, kind, strlen(kind));
+    if (peer != NULL)
+    {
+        struct rtattr* data = add_attribute(&request, IFLA_INFO_DATA, NULL, 0);
+        struct ifinfomsg peer_info = {.ifi_family = AF_UNSPEC};
+        struct rtattr* peer_attribute = add_attribute(&request, VETH_INFO_PEER, &peer_info, sizeof(peer_info));
+        add_attribute(&request, IFLA_IFNAME, peer, strlen(peer) + 1);
+        end_nest(&request, peer_attribute);
+        end_nest(&request, data);
+    }
+    end_nest(&request, link_info);
+
+    if (send(fd, &request, request.header.nlmsg_len, 0) < 0)
+    {
+        return -1;
+    }
+
+    char answer[1024];
+    ssize_t received = recv(fd, answer, sizeof(answer), 0);
+    if (received < (ssize_t)NLMSG_LENGTH(sizeof(struct nlmsgerr)))
+    {
+        errno = received < 0 ? errno : EPROTO;
+        return -1;
+    }
+    const struct nlmsghdr* header = (const struct nlmsghdr*)answer;
+    const struct nlmsgerr* error = NLMSG_DATA(header);
+    if (header->nlmsg_type == NLMSG_ERROR && error->error != 0)
+    {
+        errno = -error->error;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Creates the links of the benchmark in the current network namespace.
+ *
+ * @return 0 on success, or -1 in case of error.
+ */
+static int create_links(unsigned long links, bool veth)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int result = 0;
+    for (unsigned long i = 0; i < (veth ? links / 2 : links) && result == 0; i++)
+    {
+        char name[2 * INTERFACE_NAME_SIZE]; // Room for any index; the kernel rejects names that do not fit
+        char peer[2 * INTERFACE_NAME_SIZE];
+        snprintf(name, sizeof(name), veth ? "veth%lu" : "dummy%lu", i);
+        snprintf(peer, sizeof(peer), "vpeer%lu", i);
+        result = create_link(fd, name, veth ? "veth" : "dummy", veth ? peer : NULL);
+    }
+    close(fd);
+    return result;
+}
+
+/**
+ * @brief Orders interfaces by name.
+ */
+static int compare_names(const void* a, const void* b)
+{
+    return strcmp(((const InterfaceStats*)a)->name, ((const InterfaceStats*)b)->name);
+}
+
+/**
+ * @brief Checks that both backends report the same interfaces with the same counters.
+ *
+ * Counters of live links may move between the two reads; in a fresh namespace nothing sends traffic.
+ *
+ * @return The number of interfaces whose counters differ, or -1 if the sets differ.
+ */
+static long compare_backends(InterfaceStats* proc, ssize_t proc_count, InterfaceStats* netlink, ssize_t netlink_count)
+{
+    if (proc_count != netlink_count)
+    {
+        return -1;
+    }
+    qsort(proc, (size_t)proc_count, sizeof(InterfaceStats), compare_names);
+    qsort(netlink, (size_t)netlink_count, sizeof(InterfaceStats), compare_names);
+
+    long differing = 0;
+    for (ssize_t i = 0; i < proc_count; i++)
+    {
+        if (strcmp(proc[i].name, netlink[i].name) != 0)
+        {
+            return -1;
+        }
+        differing += memcmp(proc[i].counters, netlink[i].counters, sizeof(proc[i].counters)) != 0;
+    }
+    return differing;
+}
+
+/**
+ * @brief Times get_interface_stats() through the backend currently selected.
+ *
+ * @return Nanoseconds per call.
+ */
+static double time_backend(int iterations, InterfaceStats** interfaces, size_t* capacity)
+{
+    get_interface_stats(interfaces, capacity); // Warm up the descriptor, the buffers and the array
+    double start = now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        get_interface_stats(interfaces, capacity);
+    }
+    return (now_ns() - start) / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    long links = argc > 2 ? atol(argv[2]) : DEFAULT_LINKS;
+    bool veth = argc <= 3 || strcmp(argv[3], "dummy") != 0;
+    if (iterations <= 0)
+    {
+        iterations = DEFAULT_ITERATIONS;
+    }
+    if (links <= 0)
+    {
+        links = DEFAULT_LINKS;
+    }
+
+    if (unshare(CLONE_NEWNET) != 0)
+    {
+        perror("Error creating a network namespace (run as root)");
+        return EXIT_FAILURE;
+    }
+    double start = now_ns();
+    if (create_links((unsigned long)links, veth) != 0)
+    {
+        perror(veth ? "Error creating veth links" : "Error creating dummy links (try veth)");
+        return EXIT_FAILURE;
+    }
+    printf("created %ld %s links in %.0f ms\n", veth ? links / 2 * 2 : links, veth ? "veth" : "dummy",
+           (now_ns() - start) / 1e6);
+
+    InterfaceStats* proc = NULL;
+    size_t proc_capacity = 0;
+    ssize_t proc_count = get_interface_stats(&proc, &proc_capacity);
+    if (netlink_stats_init() != 0)
+    {
+        perror("Error opening the netlink socket");
+        return EXIT_FAILURE;
+    }
+    InterfaceStats* netlink = NULL;
+    size_t netlink_capacity = 0;
+    ssize_t netlink_count = get_interface_stats(&netlink, &netlink_capacity);
+    long differing = compare_backends(proc, proc_count, netlink, netlink_count);
+    if (differing != 0)
+    {
+        fprintf(stderr, "Backends disagree: %zd interfaces from /proc/net/dev, %zd from netlink, %ld differing\n",
+                proc_count, netlink_count, differing);
+        return EXIT_FAILURE;
+    }
+
+    netlink_stats_close();
+    double proc_ns = time_backend(iterations, &proc, &proc_capacity);
+    netlink_stats_init();
+    double netlink_ns = time_backend(iterations, &netlink, &netlink_capacity);
+
+    printf("%-16s %10s %14s %8s\n", "backend", "interfaces", "us per read", "speedup");
+    printf("%-16s %10zd %14.1f %8s\n", "/proc/net/dev", proc_count, proc_ns / 1e3, "1.0x");
+    printf("%-16s %10zd %14.1f %7.1fx\n", "netlink", netlink_count, netlink_ns / 1e3, proc_ns / netlink_ns);
+
+    netlink_stats_close();
+    free(proc);
+    free(netlink);
+    return EXIT_SUCCESS;
+}
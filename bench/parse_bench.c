@@ -0,0 +1,218 @@
+/**
+ * @file parse_bench.c
+ * @brief Microbenchmark of the procfs parsers against the fgets/sscanf parsers they replaced.
+ *
+ * Each file is read once from the live system and then parsed repeatedly from memory, so the numbers cover parsing
+ * only. The legacy parsers are kept here verbatim in spirit: an fgets() loop over the buffer with the sscanf formats
+ * the getters used before.
+ *
+ * With a proc root (e.g. a tree written by proc_fixture), the files are read from there instead, which makes the
+ * numbers reproducible at production scale. The process scan, which walks every /proc/<pid>/stat, is timed too.
+ *
+ * Usage: parse_bench [iterations] [proc_root]
+ *
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "metrics.h"
+#include "reader_cache.h"
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 20000 /**< Parses per file when no count is given. */
+#define SCAN_ITERATIONS 5        /**< Process scans timed. */
+
+static volatile unsigned long long sink; /**< Keeps the compiler from discarding parse results. */
+
+/**
+ * @brief Retrieves the current CLOCK_MONOTONIC time in nanoseconds.
+ */
+static double now_ns(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1e9 + (double)time.tv_nsec;
+}
+
+static void legacy_meminfo(const char* buffer)
+{
+    FILE* file = fmemopen((void*)buffer, strlen(buffer), "r");
+    char line[BUFFER_SIZE];
+    unsigned long long total = 0, free_mem = 0, buffers = 0, cached = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        sscanf(line, "MemTotal: %llu kB", &total);
+        sscanf(line, "MemFree: %llu kB", &free_mem);
+        sscanf(line, "Buffers: %llu kB", &buffers);
+        sscanf(line, "Cached: %llu kB", &cached);
+    }
+    fclose(file);
+    sink += total - free_mem - buffers - cached;
+}
+
+static void current_meminfo(const char* buffer)
+{
+    static MeminfoSnapshot snapshot;
+    unsigned long long total = 0, free_mem = 0, buffers = 0, cached = 0;
+    parse_meminfo(buffer, &snapshot);
+    meminfo_lookup(&snapshot, PARSE_KEY("MemTotal"), &total);
+    meminfo_lookup(&snapshot, PARSE_KEY("MemFree"), &free_mem);
+    meminfo_lookup(&snapshot, PARSE_KEY("Buffers"), &buffers);
+    meminfo_lookup(&snapshot, PARSE_KEY("Cached"), &cached);
+    sink += total - free_mem - buffers - cached;
+}
+
+static void legacy_proc_stat(const char* buffer)
+{
+    FILE* file = fmemopen((void*)buffer, strlen(buffer), "r");
+    char line[BUFFER_SIZE];
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal, ctxt = 0, running = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (strncmp(line, "cpu ", 4) == 0)
+        {
+            sscanf(line, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait, &irq,
+                   &softirq, &steal);
+            sink += user;
+        }
+        else if (strncmp(line, "ctxt", 4) == 0)
+        {
+            sscanf(line, "ctxt %llu", &ctxt);
+        }
+        else if (strncmp(line, "procs_running", 13) == 0)
+        {
+            sscanf(line, "procs_running %llu", &running);
+        }
+    }
+    fclose(file);
+    sink += ctxt + running;
+}
+
+static void current_proc_stat(const char* buffer)
+{
+    ProcStatSnapshot snapshot = {0};
+    parse_proc_stat(buffer, &snapshot, NULL, 0);
+    sink += snapshot.cpu.user + snapshot.context_switches + snapshot.procs_running;
+}
+
+static void legacy_net_dev(const char* buffer)
+{
+    FILE* file = fmemopen((void*)buffer, strlen(buffer), "r");
+    char line[BUFFER_SIZE];
+    fgets(line, sizeof(line), file);
+    fgets(line, sizeof(line), file);
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long long r_bytes, t_bytes, r_errors, t_errors, drop;
+        // Every interface is parsed, as the current parser exports each of them
+        if (sscanf(line, "%*[^:]: %llu %*d %llu %llu %*d %*d %*d %*d %llu %*d %llu", &r_bytes, &r_errors, &drop,
+                   &t_bytes, &t_errors) == 5)
+        {
+            sink += r_bytes + t_bytes;
+        }
+    }
+    fclose(file);
+}
+
+static void current_net_dev(const char* buffer)
+{
+    static InterfaceStats* interfaces = NULL;
+    static size_t capacity = 0;
+    ssize_t count = parse_net_dev(buffer, &interfaces, &capacity);
+    for (ssize_t i = 0; i < count; i++)
+    {
+        sink += interfaces[i].counters[NET_RX_BYTES] + interfaces[i].counters[NET_TX_BYTES];
+    }
+}
+
+static void legacy_diskstats(const char* buffer)
+{
+    FILE* file = fmemopen((void*)buffer, strlen(buffer), "r");
+    char line[BUFFER_SIZE];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        long long it, wc, rc;
+        if (sscanf(line, "%*d %*d %*s %lld %*d %*d %*d %lld %*d %lld", &rc, &wc, &it) == 3)
+        {
+            sink += (unsigned long long)(rc + wc + it);
+        }
+    }
+    fclose(file);
+}
+
+static void current_diskstats(const char* buffer)
+{
+    DiskStats stats;
+    parse_diskstats(buffer, &stats);
+    sink += stats.reads_completed + stats.writes_completed + stats.io_time;
+}
+
+/**
+ * @brief Times one parser over a buffer.
+ *
+ * @return Nanoseconds per parse.
+ */
+static double time_parser(void (*parser)(const char*), const char* buffer, int iterations)
+{
+    parser(buffer); // Warm up caches
+    double start = now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        parser(buffer);
+    }
+    return (now_ns() - start) / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    struct
+    {
+        const char* path;
+        void (*legacy)(const char*);
+        void (*current)(const char*);
+    } cases[] = {
+        {PROC_MEMINFO_PATH, legacy_meminfo, current_meminfo},
+        {PROC_STAT_PATH, legacy_proc_stat, current_proc_stat},
+        {PROC_NET_DEV_PATH, legacy_net_dev, current_net_dev},
+        {DISKSTATS_PATH, legacy_diskstats, current_diskstats},
+    };
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+    {
+        iterations = DEFAULT_ITERATIONS;
+    }
+    if (argc > 2 && reader_set_roots(argv[2], NULL) != 0)
+    {
+        fprintf(stderr, "proc root too long: %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%-16s %8s %14s %14s %8s\n", "file", "bytes", "sscanf ns", "parser ns", "speedup");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        char* buffer = NULL;
+        size_t capacity = 0;
+        ssize_t length = reader_read_all(cases[i].path, &buffer, &capacity);
+        if (length < 0)
+        {
+            printf("%-16s unavailable\n", cases[i].path);
+            continue;
+        }
+
+        double legacy_ns = time_parser(cases[i].legacy, buffer, iterations);
+        double current_ns = time_parser(cases[i].current, buffer, iterations);
+        printf("%-16s %8zd %14.0f %14.0f %7.1fx\n", cases[i].path, length, legacy_ns, current_ns,
+               legacy_ns / current_ns);
+        free(buffer);
+    }
+
+    int total = 0, suspended, ready, blocked;
+    double start = now_ns();
+    for (int i = 0; i < SCAN_ITERATIONS; i++)
+    {
+        get_process_states(&total, &suspended, &ready, &blocked);
+    }
+    printf("process scan: %d processes, %.1f ms per scan\n", total, (now_ns() - start) / SCAN_ITERATIONS / 1e6);
+
+    return 0;
+}
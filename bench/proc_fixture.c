@@ -0,0 +1,300 @@
+/**
+ * @file proc_fixture.c
+ * @brief Generator of synthetic /proc and /sys trees at production scale.
+ *
+ * Writes every file the collectors read, sized like a large host: a /proc/stat with one cpu line per core, a
+ * /proc/<pid>/stat per process, one /proc/net/dev line per interface and one /proc/diskstats line per disk, plus the
+ * hwmon and cpufreq attributes. Counters come from a fixed-seed generator, so the same arguments always produce the
+ * same tree. Point the exporter or parse_bench at it with MONITOR_PROC_ROOT=<directory>/proc and
+ * MONITOR_SYS_ROOT=<directory>/sys.
+ *
+ * Usage: proc_fixture <directory> [cpus] [processes] [interfaces] [disks]
+ *
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define DEFAULT_CPUS 192                   /**< Cores when no count is given. */
+#define DEFAULT_PROCESSES 100000           /**< Processes when no count is given. */
+#define DEFAULT_INTERFACES 64              /**< Network interfaces when no count is given. */
+#define DEFAULT_DISKS 32                   /**< Block devices when no count is given. */
+#define FIXTURE_PATH_SIZE 512              /**< Maximum length of a generated path. */
+#define FIXTURE_SEED 0x9e3779b97f4a7c15ULL /**< Seed of the counter generator. */
+#define MONITORED_INTERFACE "wlp4s0"       /**< Wireless interface, listed second. */
+
+static unsigned long long random_state = FIXTURE_SEED; /**< State of the xorshift generator. */
+
+/**
+ * @brief Draws the next value of a xorshift64 generator, below a bound.
+ */
+static unsigned long long next_random(unsigned long long bound)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state % bound;
+}
+
+/**
+ * @brief Creates a directory and its missing parents.
+ *
+ * @return 0 on success, or -1 in case of error.
+ */
+static int make_directories(const char* path)
+{
+    char partial[FIXTURE_PATH_SIZE];
+    size_t length = strlen(path);
+    if (length >= sizeof(partial))
+    {
+        return -1;
+    }
+
+    memcpy(partial, path, length + 1);
+    for (size_t i = 1; i <= length; i++)
+    {
+        if (partial[i] == '/' || partial[i] == '\0')
+        {
+            char saved = partial[i];
+            partial[i] = '\0';
+            if (mkdir(partial, 0755) != 0 && errno != EEXIST)
+            {
+                return -1;
+            }
+            partial[i] = saved;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Creates a file below the fixture directory, making its parent directories.
+ *
+ * @return The open file, or NULL in case of error.
+ */
+static FILE* create_file(const char* root, const char* relative)
+{
+    char path[FIXTURE_PATH_SIZE];
+    if (snprintf(path, sizeof(path), "%s/%s", root, relative) >= (int)sizeof(path))
+    {
+        return NULL;
+    }
+
+    char* slash = strrchr(path, '/');
+    *slash = '\0';
+    if (make_directories(path) != 0)
+    {
+        return NULL;
+    }
+    *slash = '/';
+    return fopen(path, "w");
+}
+
+/**
+ * @brief Writes a sysfs attribute holding a single value.
+ */
+static int write_attribute(const char* root, const char* relative, unsigned long long value)
+{
+    FILE* file = create_file(root, relative);
+    if (file == NULL)
+    {
+        return -1;
+    }
+    fprintf(file, "%llu\n", value);
+    return fclose(file);
+}
+
+/**
+ * @brief Writes a cpu line of /proc/stat with plausible jiffy counters.
+ */
+static void write_cpu_line(FILE* file, const char* name, unsigned long long scale)
+{
+    fprintf(file, "%s %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n", name, scale * (1000 + next_random(100000)),
+            scale * next_random(1000), scale * (500 + next_random(50000)), scale * (100000 + next_random(1000000)),
+            scale * next_random(5000), scale * next_random(500), scale * next_random(2000), scale * next_random(100));
+}
+
+static int write_proc_stat(const char* root, unsigned long cpus)
+{
+    FILE* file = create_file(root, "proc/stat");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    write_cpu_line(file, "cpu ", cpus);
+    for (unsigned long i = 0; i < cpus; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "cpu%lu", i);
+        write_cpu_line(file, name, 1);
+    }
+    fprintf(file, "intr %llu", next_random(1ULL << 40));
+    for (int i = 0; i < 256; i++)
+    {
+        fprintf(file, " %llu", next_random(1000000));
+    }
+    fprintf(file, "\nctxt %llu\nbtime 1760000000\nprocesses %llu\nprocs_running %llu\nprocs_blocked %llu\n",
+            next_random(1ULL << 40), next_random(1ULL << 24), next_random(cpus) + 1, next_random(16));
+    fprintf(file, "softirq %llu 0 0 0 0 0 0 0 0 0 0\n", next_random(1ULL << 36));
+    return fclose(file);
+}
+
+static int write_meminfo(const char* root)
+{
+    static const char* fields[] = {
+        "MemTotal",   "MemFree",        "MemAvailable", "Buffers",        "Cached",        "SwapCached",
+        "Active",     "Inactive",       "Active(anon)", "Inactive(anon)", "Active(file)",  "Inactive(file)",
+        "Mlocked",    "SwapTotal",      "SwapFree",     "Dirty",          "Writeback",     "AnonPages",
+        "Mapped",     "Shmem",          "KReclaimable", "Slab",           "SReclaimable",  "SUnreclaim",
+        "PageTables", "Committed_AS",   "VmallocTotal", "Percpu",         "AnonHugePages", "HugePages_Total",
+        "HugePages_Free", "Hugepagesize",
+    };
+    FILE* file = create_file(root, "proc/meminfo");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    unsigned long long total = 1ULL << 31; // 2 TiB in kB
+    fprintf(file, "%-16s%13llu kB\n", "MemTotal:", total);
+    for (size_t i = 1; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%s:", fields[i]);
+        bool pages = strncmp(fields[i], "HugePages_", 10) == 0;
+        fprintf(file, pages ? "%-16s%13llu\n" : "%-16s%13llu kB\n", name, next_random(total));
+    }
+    return fclose(file);
+}
+
+static int write_net_dev(const char* root, unsigned long interfaces)
+{
+    FILE* file = create_file(root, "proc/net/dev");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    fputs("Inter-|   Receive                                                |  Transmit\n"
+          " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls "
+          "carrier compressed\n",
+          file);
+    for (unsigned long i = 0; i < interfaces; i++)
+    {
+        char name[32];
+        if (i < 2)
+        {
+            snprintf(name, sizeof(name), "%s", i == 0 ? "lo" : MONITORED_INTERFACE);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "eth%lu", i - 2);
+        }
+        fprintf(file, "%6s:", name);
+        for (int counter = 0; counter < 16; counter++)
+        {
+            fprintf(file, " %llu", next_random(counter % 8 == 0 ? 1ULL << 48 : 1ULL << 20));
+        }
+        fputc('\n', file);
+    }
+    return fclose(file);
+}
+
+static int write_diskstats(const char* root, unsigned long disks)
+{
+    FILE* file = create_file(root, "proc/diskstats");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    for (unsigned long i = 0; i < disks; i++)
+    {
+        fprintf(file, " 259 %8lu nvme%lun1", i, i);
+        for (int counter = 0; counter < 17; counter++)
+        {
+            fprintf(file, " %llu", next_random(1ULL << 32));
+        }
+        fputc('\n', file);
+    }
+    return fclose(file);
+}
+
+static int write_processes(const char* root, unsigned long processes)
+{
+    static const char states[] = "SSSSSSSSRDIZ"; /**< State mix, mostly sleeping. */
+    for (unsigned long pid = 1; pid <= processes; pid++)
+    {
+        char relative[64];
+        snprintf(relative, sizeof(relative), "proc/%lu/stat", pid);
+        FILE* file = create_file(root, relative);
+        if (file == NULL)
+        {
+            return -1;
+        }
+        // Some command names contain spaces and parentheses, which the parser must skip correctly
+        fprintf(file, "%lu (%s%lu) %c %lu %lu %lu 0 -1 4194304 %llu 0 0 0 %llu %llu 0 0 20 0 1 0 %llu %llu %llu\n",
+                pid, pid % 7 == 0 ? "kworker/u:(x) " : "worker", pid % 1000, states[next_random(sizeof(states) - 1)],
+                pid > 1 ? 1UL : 0UL, pid, pid, next_random(100000), next_random(100000), next_random(100000),
+                next_random(1ULL << 32), next_random(1ULL << 34), next_random(1ULL << 20));
+        if (fclose(file) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int write_sys(const char* root)
+{
+    int result = 0;
+    result |= write_attribute(root, "sys/class/hwmon/hwmon4/temp1_input", 40000 + next_random(40000));
+    result |= write_attribute(root, "sys/class/hwmon/hwmon2/in0_input", 11000 + next_random(2000));
+    result |= write_attribute(root, "sys/class/hwmon/hwmon2/curr1_input", next_random(3000));
+    result |= write_attribute(root, "sys/class/hwmon/hwmon5/fan1_input", 800 + next_random(2000));
+    result |= write_attribute(root, "sys/class/hwmon/hwmon5/fan2_input", 800 + next_random(2000));
+    result |= write_attribute(root, "sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq",
+                              800000 + next_random(3000000));
+    return result;
+}
+
+/**
+ * @brief Parses an optional positive count argument.
+ */
+static unsigned long count_argument(int argc, char* argv[], int index, unsigned long fallback)
+{
+    unsigned long value = argc > index ? strtoul(argv[index], NULL, 10) : 0;
+    return value > 0 ? value : fallback;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <directory> [cpus] [processes] [interfaces] [disks]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* root = argv[1];
+    unsigned long cpus = count_argument(argc, argv, 2, DEFAULT_CPUS);
+    unsigned long processes = count_argument(argc, argv, 3, DEFAULT_PROCESSES);
+    unsigned long interfaces = count_argument(argc, argv, 4, DEFAULT_INTERFACES);
+    unsigned long disks = count_argument(argc, argv, 5, DEFAULT_DISKS);
+
+    if (write_proc_stat(root, cpus) != 0 || write_meminfo(root) != 0 || write_net_dev(root, interfaces) != 0 ||
+        write_diskstats(root, disks) != 0 || write_processes(root, processes) != 0 || write_sys(root) != 0)
+    {
+        perror("Error writing the fixture");
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %lu cpus, %lu processes, %lu interfaces, %lu disks\n", root, cpus, processes, interfaces, disks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#ifndef BATCH_READER_H
+#define BATCH_READER_H
+
+/**
+ * @file batch_reader.h
+ * @brief Header file for the optional io_uring batch reader.
+ *
+ * When enabled, the scheduler hands the procfs files read by the groups due in a tick to this module before queuing
+ * the groups, and all of them are read with a single io_uring_enter() into registered buffers through registered
+ * (fixed) files. The reader cache then serves the next read of each of those files from the completed buffer instead
+ * of issuing its own pread() calls. Each prefetched buffer is consumed by at most one read.
+ *
+ * io_uring is used through the raw system calls, so there is no dependency on liburing. When the kernel does not
+ * support it, it is disabled (e.g. kernel.io_uring_disabled), or the tree is built without HAVE_IO_URING,
+ * batch_reader_init() fails and every read keeps going through the pread() path.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define BATCH_READER_MAX_FILES 16      /**< Maximum number of files read in a batch. */
+#define BATCH_READER_BUFFER_SIZE 65536 /**< Size of the registered buffer of each file. */
+#define BATCH_READER_QUEUE_DEPTH 32    /**< Number of submission queue entries. */
+
+/**
+ * @brief Sets up the io_uring instance and its registered buffers.
+ *
+ * @return 0 on success, or -1 if io_uring is not available; the pread() path stays in use.
+ */
+int batch_reader_init(void);
+
+/**
+ * @brief Checks whether the batch reader was initialized successfully.
+ *
+ * @return true if prefetches are served through io_uring.
+ */
+bool batch_reader_enabled(void);
+
+/**
+ * @brief Reads a set of files in one batch.
+ *
+ * Files seen for the first time are opened and registered. Files that do not fit BATCH_READER_BUFFER_SIZE, fail to
+ * read or exceed BATCH_READER_MAX_FILES are left to the pread() path. Does nothing if the batch reader is disabled.
+ *
+ * @param paths The files to read. Duplicates are read once.
+ * @param num_paths Number of paths.
+ */
+void batch_reader_prefetch(const char* paths[], size_t num_paths);
+
+/**
+ * @brief Takes the prefetched contents of a file, if any.
+ *
+ * @param path The file to look up.
+ * @param buffer Pointer to the destination buffer.
+ * @param capacity Pointer to the size of the buffer.
+ * @param growable Whether the buffer is heap-allocated and may be reallocated.
+ * @return The number of bytes copied (the buffer is NUL-terminated), or -1 if no prefetched contents are available.
+ */
+ssize_t batch_reader_take(const char* path, char** buffer, size_t* capacity, bool growable);
+
+/**
+ * @brief Retrieves the number of io_uring_enter() calls issued so far.
+ *
+ * @return The number of calls.
+ */
+unsigned long long batch_reader_enter_calls(void);
+
+#endif // BATCH_READER_H
@@ -0,0 +1,113 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/**
+ * @file capture.h
+ * @brief Header file for recording procfs/sysfs inputs and replaying them through the collectors.
+ *
+ * In record mode, every read made through the reader cache is appended to a capture file together with the tick of
+ * the group run it belongs to, and every group run is recorded as a marker. In replay mode, the reader cache serves
+ * reads from the capture instead of the filesystem, and the recorded group runs are executed again tick by tick, as
+ * fast as the collectors go. Replaying therefore reproduces exactly what a misbehaving exporter saw, and measures the
+ * collectors' throughput in ticks per second against real workloads.
+ *
+ * The file is append-only: an 8-byte magic followed by records, each a fixed header (type, tick, path length
+ * including the terminator, data length) followed by the path and the raw bytes. A negative data length records a
+ * failed read and holds -errno. Integers are in host byte order; captures are replayed on the architecture that
+ * recorded them.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define CAPTURE_MAGIC "PAOSCAP1"       /**< First bytes of a capture file. */
+#define CAPTURE_BUFFER_SIZE (1 << 20) /**< stdio buffer of the capture file while recording. */
+
+/**
+ * @brief Starts recording reads to a capture file, truncating it.
+ *
+ * @param path The capture file.
+ * @return 0 on success, or -1 if the file could not be created.
+ */
+int capture_record_start(const char* path);
+
+/**
+ * @brief Loads a capture file and switches the reader cache to serving reads from it.
+ *
+ * @param path The capture file.
+ * @return 0 on success, or -1 if the file could not be read or is not a capture.
+ */
+int capture_replay_open(const char* path);
+
+/**
+ * @brief Checks whether reads are being recorded.
+ *
+ * @return true in record mode.
+ */
+bool capture_recording(void);
+
+/**
+ * @brief Checks whether reads are served from a capture.
+ *
+ * @return true in replay mode.
+ */
+bool capture_replaying(void);
+
+/**
+ * @brief Marks the start of a group run on the calling thread. Does nothing unless recording.
+ *
+ * @param group Name of the group.
+ * @param tick Collection tick the run belongs to; the reads made by this thread until the next call are tagged with it.
+ */
+void capture_begin_group(const char* group, unsigned long long tick);
+
+/**
+ * @brief Marks the end of a group run, flushing what it recorded. Does nothing unless recording.
+ */
+void capture_end_group(void);
+
+/**
+ * @brief Records a read. Does nothing unless recording.
+ *
+ * @param path The path read.
+ * @param data The bytes read.
+ * @param length The number of bytes, or -1 if the read failed (errno is recorded).
+ */
+void capture_record_read(const char* path, const char* data, ssize_t length);
+
+/**
+ * @brief Serves a read from the capture: the next recorded read of the path in the current replay tick.
+ *
+ * @param path The path to read.
+ * @param buffer Pointer to the destination buffer.
+ * @param capacity Pointer to the size of the buffer.
+ * @param growable Whether the buffer is heap-allocated and may be reallocated.
+ * @return The number of bytes copied (the buffer is NUL-terminated), or -1 with errno set to the recorded error, or to
+ * ENOENT if the tick has no such read left.
+ */
+ssize_t capture_replay_read(const char* path, char** buffer, size_t* capacity, bool growable);
+
+/**
+ * @brief Advances the replay to the next recorded tick.
+ *
+ * @return false once every tick has been replayed.
+ */
+bool capture_replay_next_tick(void);
+
+/**
+ * @brief Retrieves the next group run recorded in the current replay tick.
+ *
+ * @return The group name, or NULL once every run of the tick has been returned.
+ */
+const char* capture_replay_next_group(void);
+
+/**
+ * @brief Flushes and closes the capture file, or unloads the replayed capture.
+ */
+void capture_close(void);
+
+#endif // CAPTURE_H
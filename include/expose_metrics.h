@@ -9,15 +9,21 @@
  * such as CPU usage, memory usage, disk stats, and network traffic through Prometheus gauges. These metrics are
  * collected from the system and made available via an HTTP server for monitoring purposes.
  *
- * The metrics include usage statistics for CPU, memory, disk, network, battery, and more. The metrics are updated
- * safely in a multi-threaded environment using mutexes to ensure thread safety.
+ * The metrics include usage statistics for CPU, memory, disk, network, battery, and more. Values set during a
+ * collector group run are staged in a per-group batch and published together when the run ends, as one generation,
+ * by swapping the batch in atomically. The /metrics renderer applies the newest batch of every group right before
+ * rendering, so a scrape never mixes rx_bytes from one tick with tx_bytes from the previous one, it reports the
+ * generation it belongs to as metrics_generation, and collectors never share a lock with each other or with it.
  *
  * @date 09/10/2024
  * @author 1v6n
  */
 
 #include "metrics.h"
+#include "reader_cache.h"
+#include "sample_ring.h"
 #include <errno.h>
+#include <limits.h>
 #include <prom.h>
 #include <promhttp.h>
 #include <pthread.h>
@@ -29,19 +35,256 @@
 #include <string.h>
 #include <unistd.h>
 
+#define METRIC_INDEX_SIZE 128                        /**< Slots in the metric name hash index (power of two). */
+#define GROUP_MAX_FILES 2                            /**< Maximum number of batched files per collector group. */
+#define DEFAULT_INTERVAL_MS (SLEEP_TIME * 1000U)     /**< Default collection interval of a group in milliseconds. */
+#define PUBLISH_BATCH_SIZE (MEMINFO_MAX_FIELDS + 32) /**< Initial capacity of a publish batch, in staged values. */
+#define ADAPTIVE_TRACKED_VALUES 16                   /**< Values per group compared to measure volatility. */
+#define ADAPTIVE_DEFAULT_THRESHOLD 0.05              /**< Relative change that counts as volatile by default. */
+#define AGGREGATE_MAX_SERIES 32                      /**< Maximum number of series with window aggregates. */
+#define AGGREGATE_NAME_SIZE 96                       /**< Maximum length of an aggregate family name. */
+#define GOVERNOR_WINDOW_MS 5000U                     /**< Period over which the CPU budget is enforced. */
+#define GOVERNOR_MAX_SHIFT 4                         /**< Largest throttle, as a power of two (16x the interval). */
+#define GOVERNOR_RELAX_RATIO 0.5                     /**< Fraction of the budget below which throttling eases. */
+
+/**
+ * @brief Identifiers of the collector groups.
+ *
+ * A collector group reads one source (a procfs file, a sysfs attribute, ...) and publishes every selected metric
+ * derived from it, so each source is read once per tick no matter how many of its metrics are selected.
+ */
+typedef enum
+{
+    GROUP_CPU,
+    GROUP_PROC_STAT,
+    GROUP_MEMORY,
+    GROUP_DISK_USAGE,
+    GROUP_DISK_STATS,
+    GROUP_NETWORK,
+    GROUP_PROCESS_STATES,
+    GROUP_CPU_TEMPERATURE,
+    GROUP_BATTERY_VOLTAGE,
+    GROUP_BATTERY_CURRENT,
+    GROUP_CPU_FREQUENCY,
+    GROUP_CPU_FAN_SPEED,
+    GROUP_GPU_FAN_SPEED,
+    GROUP_READER_CACHE,
+    GROUP_COUNT
+} CollectorGroupId;
+
+/**
+ * @brief Scheduling priorities of collector groups, highest first.
+ */
+typedef enum
+{
+    PRIORITY_HIGH,   /**< Cheap, latency-critical groups such as CPU and memory. */
+    PRIORITY_NORMAL, /**< Ordinary procfs and sysfs readers. */
+    PRIORITY_LOW,    /**< Expensive groups such as the full /proc walk. */
+    PRIORITY_COUNT
+} CollectorPriority;
+
+typedef struct
+{
+    const char* name;                   // Group name, e.g. "network"
+    int (*update_function)(void);       // Pointer to the update function, run once per tick; 0 on success
+    unsigned int interval_ms;           // Collection interval in milliseconds
+    CollectorPriority priority;         // Priority in the worker pool queue
+    bool may_block;                     // Whether the group can hang (statvfs, sysfs) and needs a timeout
+    bool enabled;                       // Whether at least one member metric was selected
+    const char* files[GROUP_MAX_FILES]; // procfs files the group reads, batched when io_uring is enabled
+    bool keeps_history;                 // Whether the group derives rates from its previous sample
+    unsigned int min_interval_ms;       // Lower bound of the adaptive interval, 0 for a fixed interval
+    unsigned int max_interval_ms;       // Upper bound of the adaptive interval, 0 for a fixed interval
+} CollectorGroup;
+
 typedef struct
 {
     const char* name;
     const char* description;
     prom_gauge_t** metric;
-    void (*update_function)(void); // Pointer to the update function
+    CollectorGroupId group;  // Collector group that publishes this metric
+    size_t label_count;      // Number of label keys, 0 for plain gauges
+    const char** label_keys; // Label keys for labeled families, NULL for plain gauges
 } MetricInfo;
 
 extern MetricInfo all_metrics[];
+extern CollectorGroup all_groups[];
+
+/**
+ * @brief Looks up a metric by name.
+ *
+ * The lookup goes through a hash index built on first use instead of scanning all_metrics.
+ *
+ * @param name The metric name.
+ * @return The metric, or NULL if no metric has that name.
+ */
+MetricInfo* find_metric(const char* name);
+
+/**
+ * @brief Overrides collection intervals from a specification string.
+ *
+ * The specification is a comma-separated list of group=milliseconds pairs, e.g. "cpu=250,disk_usage=30000". A
+ * min:max pair instead of a single value makes the group's interval adaptive within those bounds, e.g. "cpu=100:5000".
+ *
+ * @param spec The specification string.
+ * @return 0 on success, or -1 if an entry names an unknown group or has an invalid interval.
+ */
+int set_group_intervals(const char* spec);
+
+/**
+ * @brief Enables window aggregates for the selected metrics of some collector groups.
+ *
+ * Every value a listed group publishes for one of its selected unlabeled metrics is also pushed into a fixed-size
+ * sample ring. Each scrape then exposes, alongside the instantaneous value, <name>_min, <name>_max, <name>_avg,
+ * <name>_p50, <name>_p90 and <name>_p99 over the samples taken since the previous scrape, so spikes shorter than the
+ * scrape interval stay visible. The scrape only reads the rings; it does not read /proc. Meant for groups sampled
+ * at a high rate, e.g. MONITOR_INTERVALS="cpu=100". Must be called after init_metrics() and before collection starts.
+ *
+ * @param spec Comma-separated group names, e.g. "cpu,memory".
+ * @return 0 on success, or -1 if an entry names an unknown group or there are more than AGGREGATE_MAX_SERIES series.
+ */
+int set_aggregated_groups(const char* spec);
+
+/**
+ * @brief Enables scrape-driven collection.
+ *
+ * Only the groups that keep history (rates computed from the previous sample, such as CPU usage) keep being sampled
+ * in the background. Every other enabled group is collected by the /metrics scrape itself, through the worker pool,
+ * when its last run is older than max_age_ms; scrapes within the max age are served from the published values. A
+ * scrape that arrives while another one is collecting waits for that collection instead of starting its own.
+ *
+ * @param max_age_ms Maximum age of served values in milliseconds, or 0 to sample every group in the background.
+ */
+void set_lazy_collection(unsigned int max_age_ms);
+
+/**
+ * @brief Enables adaptive intervals for the groups that have interval bounds.
+ *
+ * After each successful run, the group's values are compared with those of its previous run. When every value moved by
+ * less than the threshold (relative to its magnitude), the interval stretches by a quarter, up to the maximum; when
+ * any value moved by more, it drops straight to the minimum so an incident is sampled at full resolution. The
+ * effective interval is exported as collector_interval_seconds.
+ *
+ * @param threshold Relative change counted as volatile, e.g. 0.05, or 0 to keep every interval fixed.
+ */
+void set_adaptive_threshold(double threshold);
+
+/**
+ * @brief Retrieves the interval a collector group currently runs at.
+ *
+ * @param group The group.
+ * @return The effective interval in milliseconds: the adaptive one when enabled, interval_ms otherwise, stretched by
+ * the group's CPU budget throttle.
+ */
+unsigned int get_group_interval(const CollectorGroup* group);
+
+/**
+ * @brief Limits the CPU time the exporter spends on itself.
+ *
+ * The CPU time of every collector run is measured with the thread CPU clock and exported as
+ * collector_cpu_seconds_total. Every GOVERNOR_WINDOW_MS, or every longest group interval if that is longer,
+ * govern_cpu_budget() compares the process CPU time over the window with the budget: when over it, the interval of the
+ * group that used the most CPU in the window is doubled (up to 2^GOVERNOR_MAX_SHIFT times); when under
+ * GOVERNOR_RELAX_RATIO of it, the throttled group whose halved interval would add the least CPU is relaxed, provided
+ * the projection stays within the budget. One group changes per window, so each decision is measured before the next.
+ * Decisions are exported as collector_throttle_factor and collector_throttle_decisions_total.
+ *
+ * @param budget Share of one core the exporter may use, e.g. 0.005 for 0.5%, or 0 to disable the governor.
+ */
+void set_cpu_budget(double budget);
+
+/**
+ * @brief Enforces the CPU budget if the current window is over. Called by the scheduler after every tick.
+ */
+void govern_cpu_budget(void);
+
+/**
+ * @brief Records a finished run of a collector group.
+ *
+ * Sets collector_up for the group and counts failed runs in collector_errors_total. Failures are not logged
+ * individually; only the transitions between up and down are.
+ *
+ * @param group The group that ran.
+ * @param duration_seconds Time the run took.
+ * @param late Whether the run finished after its deadline.
+ * @param succeeded Whether the update function returned 0.
+ */
+void record_collector_run(const CollectorGroup* group, double duration_seconds, bool late, bool succeeded);
+
+/**
+ * @brief Records a run of a collector group that did not finish within the collector timeout.
+ *
+ * The group's series are marked stale (set to NaN) until a later run succeeds, and the run counts as a failure.
+ *
+ * @param group The group that timed out.
+ */
+void record_collector_timeout(const CollectorGroup* group);
+
+/**
+ * @brief Records how late the scheduler woke up for a collection tick.
+ *
+ * @param lateness_seconds Time between the tick's deadline and the actual wakeup.
+ */
+void record_tick_lateness(double lateness_seconds);
+
+/**
+ * @brief Records runs of a collector group that the scheduler skipped because it fell a whole interval behind.
+ *
+ * @param group The group that fell behind.
+ * @param missed Number of skipped runs.
+ */
+void record_tick_overrun(const CollectorGroup* group, unsigned long long missed);
+
+/**
+ * @brief Records a run of a collector group that was skipped because the previous run had not finished.
+ *
+ * @param group The group whose run was skipped.
+ */
+void record_collector_skip(const CollectorGroup* group);
+
+/**
+ * @brief Collects the collector groups that have at least one selected metric.
+ *
+ * @param groups Array to store the enabled groups.
+ * @param max_groups Size of the groups array.
+ * @return The number of enabled groups.
+ */
+size_t get_enabled_groups(CollectorGroup* groups[], size_t max_groups);
+
+/**
+ * @brief Collects the enabled groups the scheduler has to sample in the background.
+ *
+ * These are all enabled groups, or only those that keep history when scrape-driven collection is enabled.
+ *
+ * @param groups Array to store the groups.
+ * @param max_groups Size of the groups array.
+ * @return The number of groups.
+ */
+size_t get_background_groups(CollectorGroup* groups[], size_t max_groups);
+
+/**
+ * @brief Runs the update function of a collector group and publishes its values as one generation.
+ *
+ * @param group The group to run.
+ * @return The return value of the update function.
+ */
+int run_collector_group(const CollectorGroup* group);
+
+/**
+ * @brief Runs the group runs of a loaded capture again, one recorded tick after another, as fast as possible.
+ *
+ * Reads are served from the capture (see capture.h); runs of groups that are not enabled are skipped.
+ *
+ * @return The number of ticks replayed.
+ */
+unsigned long long replay_collection(void);
 
 /**
  * @brief Updates a Prometheus gauge metric with thread safety.
  *
+ * Inside run_collector_group() the value is staged and published with the rest of the run; elsewhere it is published
+ * at once. Does nothing if the gauge is NULL (not selected).
+ *
  * @param gauge The Prometheus gauge metric to update.
  * @param value The value to set for the metric.
  */
@@ -49,13 +292,41 @@ void update_gauge(prom_gauge_t* gauge, double value);
 
 /**
  * @brief Updates the CPU usage metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_cpu_gauge(void);
+
+/**
+ * @brief Updates the per-core families: the time each core spent in each mode, and each core's usage.
+ *
+ * Both come from the same read of /proc/stat as the aggregate usage. The counters of the previous run are kept in a
+ * contiguous array to compute the usage; a core's usage is skipped for one run after the set of cores changes.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_core_metrics(void);
+
+/**
+ * @brief Updates the CPU usage over the trailing 1s, 10s, 1m and 5m windows, all from the same history ring.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_cpu_windows(void);
+
+/**
+ * @brief Updates every selected metric derived from the cpu lines of /proc/stat.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_cpu_gauge(void);
+int update_cpu_group(void);
 
 /**
  * @brief Updates the memory usage metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_memory_gauge(void);
+int update_memory_gauge(void);
 
 /**
  * @brief Thread function to expose metrics via HTTP on port 8000.
@@ -65,79 +336,154 @@ void update_memory_gauge(void);
 void* expose_metrics(const void* arg);
 
 /**
- * @brief Initializes mutex and metrics.
+ * @brief Initializes metrics.
+ *
+ * Creates and registers a gauge for every selected metric and enables its collector group.
+ *
+ * @param selected_metrics Names of the selected metrics.
+ * @param num_metrics Number of selected metrics.
+ * @return 0 on success, or -1 if a name does not match any metric.
  */
-void init_metrics(const char* selected_metrics[], size_t num_metrics);
+int init_metrics(const char* selected_metrics[], size_t num_metrics);
 
 /**
- * @brief Destroys the mutex.
+ * @brief Destroys the scrape mutex and frees the groups' batches.
  */
 void destroy_mutex(void);
 
 /**
  * @brief Updates the disk usage metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_disk_gauge(void);
+int update_disk_gauge(void);
 
 /**
  * @brief Updates the running processes metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_running_processes_gauge(void);
+
+/**
+ * @brief Updates the interrupt, fork, blocked task and softirq counters from /proc/stat.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_running_processes_gauge(void);
+int update_proc_stat_counters(void);
 
 /**
  * @brief Updates the CPU temperature metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_cpu_temperature(void);
+int update_cpu_temperature(void);
 
 /**
  * @brief Updates the battery voltage metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_battery_voltage(void);
+int update_battery_voltage(void);
 
 /**
  * @brief Updates the battery current metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_battery_current(void);
+int update_battery_current(void);
 
 /**
  * @brief Updates the CPU frequency metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_cpu_frequency(void);
+int update_cpu_frequency(void);
 
 /**
  * @brief Updates the CPU fan speed metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_cpu_fan_speed(void);
+int update_cpu_fan_speed(void);
 
 /**
  * @brief Updates the GPU fan speed metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_gpu_fan_speed(void);
+int update_gpu_fan_speed(void);
 
 /**
  * @brief Updates the process states metrics.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_process_states_gauge(void);
+int update_process_states_gauge(void);
 
 /**
  * @brief Updates the memory metrics.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_memory_metrics(void);
+
+/**
+ * @brief Updates every selected metric derived from /proc/meminfo.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_memory_group(void);
+
+/**
+ * @brief Updates every selected metric derived from the /proc/stat counters.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_proc_stat_group(void);
+
+/**
+ * @brief Updates the labeled families holding every /proc/meminfo field.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_meminfo_fields(void);
+
+/**
+ * @brief Subscribes to link notifications, so the series of deleted or renamed interfaces are deleted.
+ *
+ * @return 0 on success or when no per-interface metric is selected, or -1 if netlink is not available or libprom
+ * cannot delete samples (built with TRACK_DELETED_INTERFACES=OFF).
  */
-void update_memory_metrics(void);
+int watch_interfaces(void);
 
 /**
- * @brief Updates the network traffic metrics.
+ * @brief Updates the network traffic metrics: every counter of every selected interface, and their sums.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_network_traffic_metric(void);
+int update_network_traffic_metric(void);
 
 /**
  * @brief Updates the context switches metric.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
  */
-void update_context_switches_metric(void);
+int update_context_switches_metric(void);
 
 /**
  * @brief Updates the disk stats metrics.
+ *
+ * @return 0 on success, or -1 if the source could not be read.
+ */
+int update_disk_stats_metrics(void);
+
+/**
+ * @brief Updates the reader cache metrics.
+ *
+ * @return Always 0.
  */
-void update_disk_stats_metrics(void);
+int update_reader_cache_metrics(void);
 
 /**
  * @brief Prints all available metrics with their names and descriptions.
@@ -0,0 +1,42 @@
+#ifndef INTERFACE_FILTER_H
+#define INTERFACE_FILTER_H
+
+/**
+ * @file interface_filter.h
+ * @brief Header file for the include/exclude patterns selecting which network interfaces are exported.
+ *
+ * Patterns are comma-separated shell globs ("eth*,bond0"). They are compiled once, when set: a pattern whose only
+ * wildcards are a leading and/or trailing '*' becomes an exact, prefix, suffix or substring comparison, and only the
+ * rest go through fnmatch(). Matching an interface is then a few memcmp() calls, which keeps hosts with thousands of
+ * veth interfaces cheap to scan. An interface is selected if it matches an include pattern (or none are set) and no
+ * exclude pattern.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define INTERFACE_MAX_PATTERNS 32 /**< Maximum number of include plus exclude patterns. */
+#define INTERFACE_PATTERN_SIZE 64 /**< Maximum length of a pattern, including the terminator. */
+
+/**
+ * @brief Compiles the include and exclude pattern lists. Not thread-safe: call before collection starts.
+ *
+ * @param include Comma-separated patterns an interface must match, or NULL or "" to include every interface.
+ * @param exclude Comma-separated patterns an interface must not match, or NULL or "" to exclude none.
+ * @return 0 on success, or -1 if there are too many patterns or one is too long; the filter is then left unchanged.
+ */
+int interface_filter_set(const char* include, const char* exclude);
+
+/**
+ * @brief Checks whether an interface is selected by the compiled patterns.
+ *
+ * @param name The interface name, not necessarily NUL-terminated.
+ * @param length Length of name.
+ * @return true if the interface is to be exported.
+ */
+bool interface_filter_match(const char* name, size_t length);
+
+#endif // INTERFACE_FILTER_H
@@ -0,0 +1,83 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/**
+ * @file logger.h
+ * @brief Header file for the asynchronous, rate-limited logger used on the collection path.
+ *
+ * Collectors never write to stderr themselves: a message is formatted into a slot of a bounded lock-free ring and a
+ * background thread writes it out, so a wedged stderr pipe (e.g. a slow journald) stalls only that thread. When the
+ * ring is full the message is dropped rather than waited for. Each call site remembers the last few messages it
+ * emitted, and repeats of the same message within LOGGER_DEDUP_WINDOW_MS are suppressed; the next emitted message of
+ * that call site reports how many were. Dropped and suppressed messages are counted for export.
+ *
+ * Before logger_start() (and after logger_stop()) messages are written synchronously, which is what one-shot tools
+ * and startup errors want.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define LOGGER_RING_SIZE 256         /**< Number of message slots in the ring (power of two). */
+#define LOGGER_MESSAGE_SIZE 192      /**< Maximum length of a message, including the terminator. */
+#define LOGGER_DEDUP_WINDOW_MS 60000 /**< Window in which a repeated message of a call site is suppressed. */
+#define LOGGER_SITE_MEMORY 4         /**< Distinct recent messages remembered per call site. */
+
+/**
+ * @brief Structure to hold the deduplication state of one call site. Declared by LOG_MESSAGE().
+ */
+typedef struct
+{
+    atomic_uint hashes[LOGGER_SITE_MEMORY];       /**< Hashes of the messages emitted most recently. */
+    atomic_ullong emitted_ms[LOGGER_SITE_MEMORY]; /**< When each of those messages was last emitted. */
+    atomic_ulong suppressed;                      /**< Messages suppressed since the site last emitted one. */
+} LogSite;
+
+/**
+ * @brief Logs a printf-style message through the call site's own deduplication state.
+ */
+#define LOG_MESSAGE(...)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        static LogSite log_site;                                                                                       \
+        logger_write(&log_site, __VA_ARGS__);                                                                          \
+    } while (0)
+
+/**
+ * @brief Starts the thread that writes queued messages to stderr.
+ *
+ * @return 0 on success, or -1 if the thread could not be created; messages are then written synchronously.
+ */
+int logger_start(void);
+
+/**
+ * @brief Writes out the queued messages and stops the logger thread.
+ */
+void logger_stop(void);
+
+/**
+ * @brief Queues a message. Use LOG_MESSAGE() rather than calling this directly.
+ *
+ * @param site Deduplication state of the call site.
+ * @param format printf-style format of the message.
+ */
+void logger_write(LogSite* site, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Retrieves the number of messages dropped because the ring was full.
+ *
+ * @return The number of messages.
+ */
+unsigned long long logger_dropped(void);
+
+/**
+ * @brief Retrieves the number of messages suppressed as repeats.
+ *
+ * @return The number of messages.
+ */
+unsigned long long logger_suppressed(void);
+
+#endif // LOGGER_H
@@ -16,22 +16,24 @@
  * @author 1v6n
  */
 
+#include "proc_parse.h"
 #include <ctype.h>
 #include <dirent.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/statvfs.h> // Required for retrieving file system stats
 #include <unistd.h>
 
-#define SLEEP_TIME 1                      /**< Sleep time in seconds for the main loop. */
+#define SLEEP_TIME 1                      /**< Default collection interval in seconds. */
 #define COMMAND_SIZE 512                  /**< Size of the command buffer. */
 #define BUFFER_SIZE 1024                  /**< Buffer size for reading files. */
 #define DISKSTATS_PATH "/proc/diskstats"  /**< Path to the disk stats file. */
 #define RETURN_ERROR -1                   /**< Return value for functions that encounter an error. */
 #define PROC_STAT_PATH "/proc/stat"       /**< Path to the stat file. */
 #define PROC_NET_DEV_PATH "/proc/net/dev" /**< Path to the network device file. */
-#define NETWORK_INTERFACE "wlp4s0"        /**< Network interface to monitor. */
 #define PROC_MEMINFO_PATH "/proc/meminfo" /**< Path to the meminfo file. */
 #define PROC_STAT_PATH "/proc/stat"       /**< Path to the stat file. */
 #define ROOT_PATH "/"                     /**< Root path for the file system. */
@@ -46,6 +48,13 @@
 #define PERCENTAGE 100.0                 /**< Conversion factor for percentage values. */
 #define PROC_DIR_PATH "/proc"            /**< Path to the /proc directory. */
 #define STAT_FILE_FORMAT "/proc/%s/stat" /**< Format string for the stat file. */
+#define MEMINFO_MAX_FIELDS 128           /**< Maximum number of fields kept from /proc/meminfo. */
+#define MEMINFO_NAME_SIZE 32             /**< Maximum length of a /proc/meminfo field name. */
+#define CPU_HISTORY_SECONDS 300          /**< Length of the longest trailing cpu window, 5 min. */
+#define CPU_HISTORY_RESOLUTION_MS 100    /**< Minimum spacing of the cpu samples kept for the windows. */
+#define CPU_HISTORY_SAMPLES (CPU_HISTORY_SECONDS * 1000 / CPU_HISTORY_RESOLUTION_MS + 2) /**< Cpu samples kept. */
+#define INTERFACE_NAME_SIZE 16           /**< Maximum length of an interface name, including the terminator. */
+#define INTERFACE_INITIAL_CAPACITY 16    /**< Entries first allocated for the per-interface counters. */
 
 /**
  * @brief Reads the value from the specified file.
@@ -57,6 +66,170 @@
  */
 static double read_value(const char* path);
 
+/**
+ * @brief Structure to hold a single /proc/meminfo field.
+ */
+typedef struct
+{
+    char name[MEMINFO_NAME_SIZE]; /**< Field name without the trailing colon, e.g. "Slab". */
+    unsigned long long value;     /**< Field value, in kB when in_kb is set, otherwise a raw page count. */
+    unsigned int hash;            /**< parse_hash() of name, compared before the name itself. */
+    bool in_kb;                   /**< Whether the field is reported in kB (HugePages_* fields are not). */
+} MeminfoField;
+
+/**
+ * @brief Structure to hold a parsed snapshot of /proc/meminfo.
+ */
+typedef struct
+{
+    MeminfoField fields[MEMINFO_MAX_FIELDS]; /**< Fields in the order the kernel reports them. */
+    size_t count;                            /**< Number of valid entries in fields. */
+    unsigned long long tick;                 /**< Collection tick the snapshot was taken in. */
+    bool valid;                              /**< Whether the last read of /proc/meminfo succeeded. */
+} MeminfoSnapshot;
+
+/**
+ * @brief Structure to hold the jiffy counters of a cpu line in /proc/stat.
+ */
+typedef struct
+{
+    unsigned long long user;    /**< Time spent in user mode. */
+    unsigned long long nice;    /**< Time spent in user mode with low priority. */
+    unsigned long long system;  /**< Time spent in kernel mode. */
+    unsigned long long idle;    /**< Time spent idle. */
+    unsigned long long iowait;  /**< Time spent waiting for I/O. */
+    unsigned long long irq;     /**< Time spent servicing interrupts. */
+    unsigned long long softirq; /**< Time spent servicing softirqs. */
+    unsigned long long steal;   /**< Time stolen by the hypervisor. */
+} CpuTimes;
+
+/**
+ * @brief Structure to hold the jiffy counters of one "cpuN" line in /proc/stat.
+ */
+typedef struct
+{
+    unsigned int id; /**< N of the line; offline cores are skipped, so ids need not be contiguous. */
+    CpuTimes times;  /**< The counters. */
+} CoreTimes;
+
+/**
+ * @brief Structure to hold a parsed snapshot of /proc/stat.
+ */
+typedef struct
+{
+    CpuTimes cpu;                        /**< Aggregate "cpu" line. */
+    unsigned long long context_switches; /**< "ctxt": context switches since boot. */
+    unsigned long long interrupts;       /**< "intr": total interrupts serviced since boot. */
+    unsigned long long processes;        /**< "processes": forks since boot. */
+    unsigned long long procs_running;    /**< "procs_running": runnable tasks. */
+    unsigned long long procs_blocked;    /**< "procs_blocked": tasks blocked on I/O. */
+    unsigned long long softirqs;         /**< "softirq": total softirqs serviced since boot. */
+    size_t core_count;                   /**< Number of "cpuN" lines. */
+    unsigned long long tick;             /**< Collection tick the snapshot was taken in. */
+    bool valid;                          /**< Whether the last read of /proc/stat succeeded. */
+} ProcStatSnapshot;
+
+/**
+ * @brief Trailing windows of the CPU usage history.
+ */
+typedef enum
+{
+    CPU_WINDOW_1S,  /**< The last second. */
+    CPU_WINDOW_10S, /**< The last 10 seconds. */
+    CPU_WINDOW_1M,  /**< The last minute. */
+    CPU_WINDOW_5M,  /**< The last 5 minutes, CPU_HISTORY_SECONDS. */
+    CPU_WINDOW_COUNT
+} CpuWindow;
+
+/**
+ * @brief Starts a new collection tick.
+ *
+ * Snapshots of procfs files are read at most once per tick. Calling this function invalidates them, so the next
+ * getter that needs a snapshot reads the file again.
+ */
+void metrics_begin_tick(void);
+
+/**
+ * @brief Retrieves the current collection tick.
+ *
+ * @return The tick, which increases by one per metrics_begin_tick() call.
+ */
+unsigned long long metrics_current_tick(void);
+
+/**
+ * @brief Retrieves a copy of the /proc/meminfo snapshot for the current tick.
+ *
+ * The file is read and parsed on the first call of each tick; later calls in the same tick reuse the table. The copy
+ * keeps callers on collector threads independent of a refresh triggered by the next tick.
+ *
+ * @param snapshot Pointer to store the snapshot.
+ * @return 0 on success, or -1 if /proc/meminfo could not be read.
+ */
+int get_meminfo_snapshot(MeminfoSnapshot* snapshot);
+
+/**
+ * @brief Retrieves a copy of the /proc/stat snapshot for the current tick.
+ *
+ * The whole file is read and parsed on the first call of each tick; CPU usage, context switches and the process
+ * counters all read from the same snapshot.
+ *
+ * @param snapshot Pointer to store the snapshot.
+ * @return 0 on success, or -1 if /proc/stat could not be read.
+ */
+int get_proc_stat_snapshot(ProcStatSnapshot* snapshot);
+
+/**
+ * @brief Looks up a field in a /proc/meminfo snapshot.
+ *
+ * @param snapshot The snapshot to search.
+ * @param key The field name, e.g. PARSE_KEY("MemTotal").
+ * @param value Pointer to store the field value.
+ * @return 0 if the field was found, or -1 otherwise.
+ */
+int meminfo_lookup(const MeminfoSnapshot* snapshot, ParseKey key, unsigned long long* value);
+
+/**
+ * @brief Parses the contents of /proc/meminfo.
+ *
+ * @param buffer The file contents, NUL-terminated.
+ * @param snapshot Pointer to store the fields; tick and valid are left untouched.
+ * @return 0 on success, or -1 if no field could be parsed.
+ */
+int parse_meminfo(const char* buffer, MeminfoSnapshot* snapshot);
+
+/**
+ * @brief Retrieves a copy of the per-core counters of the /proc/stat snapshot for the current tick.
+ *
+ * The counters come from the same read as get_proc_stat_snapshot(). They are copied into one contiguous array that
+ * the caller keeps across calls, so no allocation happens per line or per call once it fits every core.
+ *
+ * @param cores Pointer to the caller's heap array, reallocated when the cores do not fit.
+ * @param capacity Pointer to the number of entries allocated in the array.
+ * @return The number of cores copied, or -1 if /proc/stat could not be read.
+ */
+ssize_t get_core_times(CoreTimes** cores, size_t* capacity);
+
+/**
+ * @brief Computes the busy share of a CPU between two samples of its counters.
+ *
+ * @param previous The earlier sample.
+ * @param current The later sample.
+ * @return The share of time not spent idle or waiting for I/O, in percent, or -1.0 if no time elapsed.
+ */
+double cpu_times_usage(const CpuTimes* previous, const CpuTimes* current);
+
+/**
+ * @brief Parses the contents of /proc/stat.
+ *
+ * @param buffer The file contents, NUL-terminated.
+ * @param snapshot Pointer to store the counters, zeroed by the caller; tick and valid are left untouched. core_count
+ * is set to the number of "cpuN" lines, even those that did not fit cores.
+ * @param cores Array receiving the "cpuN" lines in file order, or NULL to skip them.
+ * @param max_cores Number of entries in cores.
+ * @return 0 on success, or -1 if the aggregate cpu line is missing.
+ */
+int parse_proc_stat(const char* buffer, ProcStatSnapshot* snapshot, CoreTimes* cores, size_t max_cores);
+
 /**
  * @brief Retrieves the memory usage percentage from /proc/meminfo.
  *
@@ -70,13 +243,29 @@ double get_memory_usage();
 /**
  * @brief Retrieves the CPU usage percentage from /proc/stat.
  *
- * Reads CPU time values from /proc/stat and calculates the percentage of CPU usage
- * over a time interval.
+ * Reads CPU time values from the /proc/stat snapshot and calculates the percentage of CPU usage
+ * over the trailing second, as CPU_WINDOW_1S of get_cpu_window_usage() does, or since boot before a second sample
+ * exists.
+ * Any number of callers get the same value within a tick.
  *
  * @return CPU usage as a percentage (0.0 to 100.0), or -1.0 in case of error.
  */
 double get_cpu_usage();
 
+/**
+ * @brief Retrieves the CPU usage percentage over every trailing window, from one /proc/stat snapshot.
+ *
+ * /proc/stat snapshots are recorded with the time they were taken in a ring, at most one per
+ * CPU_HISTORY_RESOLUTION_MS, and a window starts at the newest recorded sample at least its length old. Each window
+ * keeps a cursor on that sample, moved forward as samples are recorded, so a window costs one lookup. A window is
+ * therefore never shorter than its length and longer by less than the collection interval plus that resolution,
+ * except at startup: until enough history has been recorded, it covers all of it.
+ *
+ * @param usage Receives the usage of each CpuWindow as a percentage, or -1.0 if no time has elapsed in it yet.
+ * @return 0 on success, or -1 if /proc/stat could not be read.
+ */
+int get_cpu_window_usage(double usage[CPU_WINDOW_COUNT]);
+
 /**
  * @brief Retrieves the disk usage percentage.
  *
@@ -151,8 +340,9 @@ double get_gpu_fan_speed();
  * @param suspended Pointer to store the number of suspended processes.
  * @param ready Pointer to store the number of ready processes.
  * @param blocked Pointer to store the number of blocked processes.
+ * @return 0 on success, or -1 if /proc could not be opened.
  */
-void get_process_states(int* total, int* suspended, int* ready, int* blocked);
+int get_process_states(int* total, int* suspended, int* ready, int* blocked);
 
 /**
  * @brief Retrieves the total memory available in the system.
@@ -184,11 +374,20 @@ double get_available_memory();
 /**
  * @brief Retrieves the number of context switches.
  *
- * Reads the number of context switches from /proc/stat.
+ * Reads the number of context switches from the /proc/stat snapshot.
  *
  * @return The number of context switches, or -1 in case of error.
  */
-int get_context_switches();
+long long get_context_switches();
+
+/**
+ * @brief Retrieves the number of runnable processes.
+ *
+ * Reads procs_running from the /proc/stat snapshot.
+ *
+ * @return The number of runnable processes, or -1 in case of error.
+ */
+long long get_running_processes();
 
 /**
  * @brief Structure to hold disk statistics.
@@ -210,25 +409,76 @@ typedef struct
 DiskStats get_disk_stats();
 
 /**
- * @brief Structure to hold network traffic statistics.
+ * @brief Parses the contents of /proc/diskstats, summing the counters of every device.
+ *
+ * @param buffer The file contents, NUL-terminated.
+ * @param stats Pointer to store the sums.
+ */
+void parse_diskstats(const char* buffer, DiskStats* stats);
+
+/**
+ * @brief Enumeration of the counters of a /proc/net/dev line, in file order.
+ */
+typedef enum
+{
+    NET_RX_BYTES,      /**< Bytes received. */
+    NET_RX_PACKETS,    /**< Packets received. */
+    NET_RX_ERRORS,     /**< Receive errors. */
+    NET_RX_DROPPED,    /**< Received packets dropped. */
+    NET_RX_FIFO,       /**< Receive FIFO overruns. */
+    NET_RX_FRAME,      /**< Receive framing errors. */
+    NET_RX_COMPRESSED, /**< Compressed packets received. */
+    NET_RX_MULTICAST,  /**< Multicast frames received. */
+    NET_TX_BYTES,      /**< Bytes transmitted. */
+    NET_TX_PACKETS,    /**< Packets transmitted. */
+    NET_TX_ERRORS,     /**< Transmit errors. */
+    NET_TX_DROPPED,    /**< Transmitted packets dropped. */
+    NET_TX_FIFO,       /**< Transmit FIFO overruns. */
+    NET_TX_COLLISIONS, /**< Collisions detected. */
+    NET_TX_CARRIER,    /**< Carrier losses. */
+    NET_TX_COMPRESSED, /**< Compressed packets transmitted. */
+    NET_DEV_COUNTERS   /**< Number of counters. */
+} NetDevCounter;
+
+/**
+ * @brief Structure to hold the counters of one network interface.
  */
 typedef struct
 {
-    unsigned long long rx_bytes;        /**< Total bytes received. */
-    unsigned long long tx_bytes;        /**< Total bytes transmitted. */
-    unsigned long long rx_errors;       /**< Total receive errors. */
-    unsigned long long tx_errors;       /**< Total transmit errors. */
-    unsigned long long dropped_packets; /**< Total dropped packets. */
-} NetworkStats;
+    char name[INTERFACE_NAME_SIZE];                /**< Interface name. */
+    unsigned long long counters[NET_DEV_COUNTERS]; /**< Counters, indexed by NetDevCounter. */
+} InterfaceStats;
 
 /**
- * @brief Retrieves network traffic statistics for the specified network interface.
+ * @brief Retrieves the counters of every network interface selected by the interface filter.
  *
- * Reads the network traffic statistics from /proc/net/dev and returns the total bytes received,
- * transmitted, and errors encountered for the "wlp4s0" interface.
+ * All sixteen counters of every line are parsed in one pass over /proc/net/dev, or fetched with one netlink dump
+ * when that backend is enabled (see netlink_stats.h), into one contiguous array that the caller keeps across calls.
+ *
+ * @param interfaces Pointer to the caller's heap array, reallocated when the interfaces do not fit.
+ * @param capacity Pointer to the number of entries allocated in the array.
+ * @return The number of interfaces, or -1 if /proc/net/dev could not be read.
+ */
+ssize_t get_interface_stats(InterfaceStats** interfaces, size_t* capacity);
+
+/**
+ * @brief Parses the contents of /proc/net/dev, keeping the interfaces selected by the interface filter.
+ *
+ * @param buffer The file contents, NUL-terminated.
+ * @param interfaces Pointer to a heap array, reallocated when the interfaces do not fit.
+ * @param capacity Pointer to the number of entries allocated in the array.
+ * @return The number of interfaces stored, or -1 if the array could not grow.
+ */
+ssize_t parse_net_dev(const char* buffer, InterfaceStats** interfaces, size_t* capacity);
+
+/**
+ * @brief Makes room for one more interface in a per-interface array, doubling it when full.
  *
- * @return A NetworkStats struct containing network traffic statistics.
+ * @param interfaces Pointer to the heap array.
+ * @param capacity Pointer to the number of entries allocated in the array.
+ * @param count Number of entries in use.
+ * @return The entry at index count, or NULL if the array could not grow.
  */
-NetworkStats get_network_traffic();
+InterfaceStats* reserve_interface(InterfaceStats** interfaces, size_t* capacity, size_t count);
 
 #endif // METRICS_H
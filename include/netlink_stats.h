@@ -0,0 +1,87 @@
+#ifndef NETLINK_STATS_H
+#define NETLINK_STATS_H
+
+/**
+ * @file netlink_stats.h
+ * @brief Header file for the optional rtnetlink backend of the per-interface network counters.
+ *
+ * When enabled, get_interface_stats() fetches the counters of every link with a single RTM_GETSTATS dump on a
+ * persistent NETLINK_ROUTE socket, asking only for IFLA_STATS_LINK_64, instead of formatting and parsing the
+ * /proc/net/dev text. That dump names links by index, so the names come from a table filled by an RTM_GETLINK dump
+ * without statistics, refreshed whenever an unknown index shows up. Kernels without RTM_GETSTATS (before 4.7) get a
+ * full RTM_GETLINK dump with IFLA_STATS64 instead, which carries several times more data than the counters. Either
+ * way the counters are folded the way /proc/net/dev folds them (e.g. "drop" includes missed packets), so both
+ * backends fill identical InterfaceStats and the exported series do not change when switching.
+ *
+ * The dump always describes the network namespace the exporter runs in: it ignores MONITOR_PROC_ROOT, and it is not
+ * recorded in captures, which keep reading /proc/net/dev. When a dump fails the socket is reopened on the next call
+ * and that call reads /proc/net/dev instead.
+ *
+ * Independently of the backend, netlink_stats_watch() subscribes to RTMGRP_LINK. The name table is then kept current
+ * from the link notifications instead of being dumped again, and every link deleted or renamed is reported once, so
+ * the exporter can delete its series. When the kernel drops notifications (the socket buffer overflowed) the table
+ * is resynchronized with one name dump, reporting the links that vanished meanwhile.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include "metrics.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define NETLINK_RECEIVE_SIZE 65536        /**< Size of the receive buffer; the kernel fills at most 32 KB per recv. */
+#define NETLINK_SOCKET_BUFFER_SIZE 1048576 /**< SO_RCVBUF of the socket, so a dump is never dropped mid-way. */
+#define NETLINK_DUMP_RETRIES 2             /**< Extra dumps attempted when links change during one. */
+#define NETLINK_NAME_TABLE_SIZE 64         /**< Initial number of slots of the index-to-name table. */
+
+/**
+ * @brief Called with the name of each link deleted or renamed while watching.
+ *
+ * @param name The name the link had; valid only during the call.
+ */
+typedef void (*LinkRemovedHandler)(const char* name);
+
+/**
+ * @brief Opens the persistent netlink socket and switches the network counters to it.
+ *
+ * @return 0 on success, or -1 if netlink is not available; /proc/net/dev stays in use.
+ */
+int netlink_stats_init(void);
+
+/**
+ * @brief Checks whether the netlink backend is in use.
+ *
+ * @return true if the network counters are fetched over netlink.
+ */
+bool netlink_stats_enabled(void);
+
+/**
+ * @brief Fetches the counters of every link selected by the interface filter with one dump.
+ *
+ * @param interfaces Pointer to the caller's heap array, reallocated when the links do not fit.
+ * @param capacity Pointer to the number of entries allocated in the array.
+ * @return The number of interfaces, or -1 if the dump failed.
+ */
+ssize_t netlink_stats_read(InterfaceStats** interfaces, size_t* capacity);
+
+/**
+ * @brief Subscribes to link notifications and loads the current links.
+ *
+ * @param handler Function called from netlink_stats_poll() (or a dump) for each link that goes away.
+ * @return 0 on success, or -1 if netlink is not available; deleted links are then not reported.
+ */
+int netlink_stats_watch(LinkRemovedHandler handler);
+
+/**
+ * @brief Applies the link notifications received since the last call. Does not block; does nothing unless watching.
+ */
+void netlink_stats_poll(void);
+
+/**
+ * @brief Closes the netlink sockets and stops watching; the network counters go back to /proc/net/dev.
+ */
+void netlink_stats_close(void);
+
+#endif // NETLINK_STATS_H
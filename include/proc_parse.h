@@ -0,0 +1,118 @@
+#ifndef PROC_PARSE_H
+#define PROC_PARSE_H
+
+/**
+ * @file proc_parse.h
+ * @brief Header file for the allocation-free procfs/sysfs text parsers.
+ *
+ * The readers in metrics.c parse whole files that were read into memory in one go. This module provides the pieces
+ * they share: a line splitter that walks the buffer without modifying it, unsigned and signed integer extraction that
+ * stops at the first non-digit, field skipping, and key matching against keys whose hash is computed once from a
+ * string literal. Nothing here allocates, copies a line or goes through the scanf format interpreter.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Structure to hold a key looked up by hash, e.g. a /proc/meminfo field name.
+ */
+typedef struct
+{
+    const char* name;  /**< Key text, not necessarily NUL-terminated. */
+    size_t length;     /**< Length of name. */
+    unsigned int hash; /**< parse_hash() of name. */
+} ParseKey;
+
+/**
+ * @brief Computes the FNV-1a hash of a key.
+ *
+ * Inline so that the hash of a string literal passed through PARSE_KEY is folded at compile time.
+ *
+ * @param text The key text.
+ * @param length Length of the key.
+ * @return The hash.
+ */
+static inline unsigned int parse_hash(const char* text, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Builds a ParseKey from a string literal.
+ */
+#define PARSE_KEY(literal) ((ParseKey){(literal), sizeof(literal) - 1, parse_hash((literal), sizeof(literal) - 1)})
+
+/**
+ * @brief Splits the next line off a NUL-terminated buffer without modifying it.
+ *
+ * @param cursor Pointer to the current position, advanced past the returned line.
+ * @param length Pointer to store the length of the line, without its newline.
+ * @return The start of the next line, or NULL at the end of the buffer.
+ */
+const char* parse_next_line(const char** cursor, size_t* length);
+
+/**
+ * @brief Skips blanks (spaces and tabs). Never moves past a newline.
+ *
+ * @param text The position to start at.
+ * @return The first non-blank character.
+ */
+const char* parse_skip_spaces(const char* text);
+
+/**
+ * @brief Parses an unsigned decimal integer, skipping leading blanks.
+ *
+ * @param text The position to start at.
+ * @param value Pointer to store the value.
+ * @return The position after the last digit, or NULL if there is no digit.
+ */
+const char* parse_u64(const char* text, unsigned long long* value);
+
+/**
+ * @brief Parses a signed decimal integer, skipping leading blanks.
+ *
+ * @param text The position to start at.
+ * @param value Pointer to store the value.
+ * @return The position after the last digit, or NULL if there is no digit.
+ */
+const char* parse_s64(const char* text, long long* value);
+
+/**
+ * @brief Skips blank-separated fields.
+ *
+ * @param text The position to start at.
+ * @param count Number of fields to skip.
+ * @return The position after the last skipped field, or NULL if the line has fewer fields.
+ */
+const char* parse_skip_fields(const char* text, unsigned int count);
+
+/**
+ * @brief Splits the key off the start of a line, e.g. "MemTotal" from "MemTotal:  16318412 kB".
+ *
+ * Leading blanks are skipped, and the key ends at the first delimiter. Trailing blanks are not part of the key.
+ *
+ * @param line The line.
+ * @param length Length of the line.
+ * @param delimiter Character that ends the key, e.g. ':' or ' '.
+ * @param key Pointer to store a key referring into the line, with its hash.
+ * @return The position after the delimiter, or NULL if the line has no delimiter.
+ */
+const char* parse_key(const char* line, size_t length, char delimiter, ParseKey* key);
+
+/**
+ * @brief Compares two keys, by hash first.
+ *
+ * @return true if the keys are equal.
+ */
+bool parse_key_equals(const ParseKey* a, const ParseKey* b);
+
+#endif // PROC_PARSE_H
@@ -0,0 +1,112 @@
+#ifndef READER_CACHE_H
+#define READER_CACHE_H
+
+/**
+ * @file reader_cache.h
+ * @brief Header file for the cached procfs/sysfs file reader.
+ *
+ * Every getter in metrics.c reads its input through this module. Files are opened once and kept open; each read is
+ * a pread() at offset 0, which makes procfs and sysfs regenerate the contents without a new open(), path lookup or
+ * FILE allocation. Descriptors are reopened automatically when the kernel reports the file as gone (ENOENT/ENODEV),
+ * e.g. after a hwmon device is re-registered. Contents prefetched by the io_uring batch reader are served first.
+ *
+ * Callers always pass the real paths ("/proc/stat", "/sys/class/hwmon/..."). When a proc or sys root is configured,
+ * every open() made for them is redirected below that root, so the collectors run unchanged against a captured or
+ * synthesized tree. Every read can also be recorded to, or served from, a capture file (see capture.h).
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define READER_CACHE_SIZE 128 /**< Maximum number of files kept open by the cache. */
+#define READER_PATH_SIZE 256  /**< Maximum length of a cached path. */
+#define READER_ROOT_SIZE 256  /**< Maximum length of a proc or sys root. */
+
+/**
+ * @brief Redirects reads of /proc and /sys below other directories.
+ *
+ * Must be called before the first read; descriptors already cached keep pointing at the old files.
+ *
+ * @param proc_root Directory standing in for /proc, or NULL/empty to read the real one.
+ * @param sys_root Directory standing in for /sys, or NULL/empty to read the real one.
+ * @return 0 on success, or -1 if a root is too long.
+ */
+int reader_set_roots(const char* proc_root, const char* sys_root);
+
+/**
+ * @brief Maps a /proc or /sys path to the file actually read under the configured roots.
+ *
+ * @param path The path to map.
+ * @param buffer Buffer receiving the mapped path when a root applies.
+ * @param size Size of the buffer.
+ * @return path itself when no root applies, buffer otherwise, or NULL if the mapped path does not fit.
+ */
+const char* reader_resolve(const char* path, char* buffer, size_t size);
+
+/**
+ * @brief Opens a file read-only under the configured roots.
+ *
+ * @param path The path to open.
+ * @return The descriptor, or -1 in case of error (errno is set).
+ */
+int reader_open(const char* path);
+
+/**
+ * @brief Reads a small file, such as a sysfs attribute, into a fixed-size buffer.
+ *
+ * @param path The path to the file to read.
+ * @param buffer Buffer receiving the contents, NUL-terminated.
+ * @param size Size of the buffer; at most size - 1 bytes are read.
+ * @return The number of bytes read, or -1 in case of error (errno is set).
+ */
+ssize_t reader_read(const char* path, char* buffer, size_t size);
+
+/**
+ * @brief Reads a whole file into a heap buffer that grows as needed.
+ *
+ * @param path The path to the file to read.
+ * @param buffer Pointer to the heap buffer, reallocated when the file does not fit.
+ * @param capacity Pointer to the allocated size of the buffer.
+ * @return The number of bytes read (the buffer is NUL-terminated), or -1 in case of error (errno is set).
+ */
+ssize_t reader_read_all(const char* path, char** buffer, size_t* capacity);
+
+/**
+ * @brief Reads a short-lived file without caching its descriptor.
+ *
+ * Used for per-process files under /proc/<pid>, which would otherwise pin one descriptor per PID.
+ *
+ * @param path The path to the file to read.
+ * @param buffer Buffer receiving the contents, NUL-terminated.
+ * @param size Size of the buffer; at most size - 1 bytes are read.
+ * @return The number of bytes read, or -1 in case of error (errno is set).
+ */
+ssize_t reader_read_transient(const char* path, char* buffer, size_t size);
+
+/**
+ * @brief Lists the entries of a directory, such as /proc, without "." and "..".
+ *
+ * @param path The directory to list.
+ * @param buffer Pointer to the heap buffer receiving the names, one per line; reallocated when they do not fit.
+ * @param capacity Pointer to the allocated size of the buffer.
+ * @return The number of bytes stored (the buffer is NUL-terminated), or -1 in case of error (errno is set).
+ */
+ssize_t reader_read_directory(const char* path, char** buffer, size_t* capacity);
+
+/**
+ * @brief Retrieves the number of open()/close() syscalls avoided by reusing cached descriptors.
+ *
+ * @return The number of syscalls saved since startup.
+ */
+unsigned long long reader_syscalls_saved(void);
+
+/**
+ * @brief Closes every cached descriptor.
+ */
+void reader_close_all(void);
+
+#endif // READER_CACHE_H
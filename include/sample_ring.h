@@ -0,0 +1,65 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+/**
+ * @file sample_ring.h
+ * @brief Header file for the fixed-size sample rings behind the per-scrape window aggregates.
+ *
+ * A group sampled at a high rate pushes every value of an aggregated series into that series' ring, and each scrape
+ * drains the samples pushed since the previous scrape into min/max/avg and quantiles. The ring never grows: when a
+ * scrape comes later than SAMPLE_RING_SIZE samples, only the newest SAMPLE_RING_SIZE are aggregated. There is one
+ * producer (the group's run) and one consumer (the scrape renderer), so neither side takes a lock.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SAMPLE_RING_SIZE 1024   /**< Samples kept per series; 100 s of history at a 100 ms interval. */
+#define SAMPLE_QUANTILE_COUNT 3 /**< Number of quantiles computed per window. */
+
+extern const double sample_quantiles[SAMPLE_QUANTILE_COUNT]; /**< Quantiles computed per window, ascending. */
+
+/**
+ * @brief Structure to hold the samples of one series.
+ */
+typedef struct
+{
+    double values[SAMPLE_RING_SIZE]; /**< Samples, indexed by sequence number modulo SAMPLE_RING_SIZE. */
+    atomic_ullong head;              /**< Sequence number of the next sample, written by the producer only. */
+    unsigned long long tail;         /**< Sequence number of the first sample not yet drained, consumer only. */
+} SampleRing;
+
+/**
+ * @brief Structure to hold the aggregates of the samples drained from a ring.
+ */
+typedef struct
+{
+    size_t count;                            /**< Number of samples aggregated. */
+    double min;                              /**< Smallest sample. */
+    double max;                              /**< Largest sample. */
+    double avg;                              /**< Arithmetic mean of the samples. */
+    double quantiles[SAMPLE_QUANTILE_COUNT]; /**< Nearest-rank quantiles, in the order of sample_quantiles. */
+} SampleWindow;
+
+/**
+ * @brief Appends a sample, overwriting the oldest one when the ring is full. Called by the producer only.
+ *
+ * @param ring The ring.
+ * @param value The sample.
+ */
+void sample_ring_push(SampleRing* ring, double value);
+
+/**
+ * @brief Aggregates the samples pushed since the previous drain and consumes them. Called by the consumer only.
+ *
+ * @param ring The ring.
+ * @param window Pointer to store the aggregates.
+ * @return true if at least one sample was drained, false if none was pushed since the previous drain.
+ */
+bool sample_ring_drain(SampleRing* ring, SampleWindow* window);
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,94 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * @file scheduler.h
+ * @brief Header file for the collector group scheduler.
+ *
+ * Each collector group runs at its own interval. Group deadlines are absolute times on CLOCK_MONOTONIC and are kept in
+ * a hierarchical timer wheel: level 0 has one slot per WHEEL_TICK_MS, and every higher level covers WHEEL_SLOTS slots
+ * of the level below. Timers are placed in the coarsest level that still resolves them and cascade down as their
+ * deadline approaches, so arming and expiring a timer costs O(1) regardless of how far away it is.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include "expose_metrics.h"
+#include <time.h>
+
+#define WHEEL_TICK_MS 10                   /**< Resolution of the timer wheel in milliseconds. */
+#define WHEEL_SLOT_BITS 6                  /**< log2 of the number of slots per level. */
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS) /**< Number of slots per level. */
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1)  /**< Mask selecting a slot index. */
+#define WHEEL_LEVELS 4                     /**< Number of levels; the top level spans about 46 hours. */
+
+/**
+ * @brief Structure to hold a timer armed in a timer wheel.
+ */
+typedef struct WheelTimer
+{
+    struct WheelTimer* next;    /**< Next timer in the same slot. */
+    unsigned long long expires; /**< Expiry time in wheel ticks. */
+    void* data;                 /**< Owner of the timer. */
+} WheelTimer;
+
+/**
+ * @brief Structure to hold a hierarchical timer wheel.
+ */
+typedef struct
+{
+    WheelTimer* slots[WHEEL_LEVELS][WHEEL_SLOTS]; /**< Singly linked timer lists per level and slot. */
+    unsigned long long now;                       /**< Current time in wheel ticks. */
+} TimerWheel;
+
+/**
+ * @brief Initializes an empty timer wheel.
+ *
+ * @param wheel The wheel to initialize.
+ * @param now The current time in wheel ticks.
+ */
+void wheel_init(TimerWheel* wheel, unsigned long long now);
+
+/**
+ * @brief Arms a timer. Timers already due expire on the next advance.
+ *
+ * @param wheel The wheel to arm the timer in.
+ * @param timer The timer, with expires set.
+ */
+void wheel_add(TimerWheel* wheel, WheelTimer* timer);
+
+/**
+ * @brief Advances the wheel and collects the timers that expired on the way.
+ *
+ * @param wheel The wheel to advance.
+ * @param target The time in wheel ticks to advance to.
+ * @return A list of expired timers linked through next, or NULL if none expired.
+ */
+WheelTimer* wheel_advance(TimerWheel* wheel, unsigned long long target);
+
+/**
+ * @brief Retrieves the earliest time at which the wheel needs to be advanced.
+ *
+ * This is the expiry of the nearest timer in level 0, or the next cascade point if level 0 is empty.
+ *
+ * @param wheel The wheel to inspect.
+ * @return The time in wheel ticks.
+ */
+unsigned long long wheel_next_expiry(const TimerWheel* wheel);
+
+/**
+ * @brief Runs the given collector groups forever, each at its own interval.
+ *
+ * Every group runs once immediately. Afterwards each group is re-armed against an absolute deadline (previous deadline
+ * plus its interval), so the time spent collecting does not accumulate as drift. Groups that fall more than one
+ * interval behind skip the missed runs instead of bursting; each skipped run is counted as an overrun. Due groups are
+ * handed to the worker pool, which must have been started, with the next deadline as the time by which the run has to
+ * finish. How late the scheduler woke up for each collection tick is recorded in a histogram.
+ *
+ * @param groups The groups to run.
+ * @param num_groups Number of groups.
+ */
+void scheduler_run(CollectorGroup* groups[], size_t num_groups);
+
+#endif // SCHEDULER_H
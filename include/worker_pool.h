@@ -0,0 +1,85 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+/**
+ * @file worker_pool.h
+ * @brief Header file for the collector worker pool.
+ *
+ * The scheduler hands due collector groups to a fixed-size pool of worker threads instead of running them on its own
+ * thread, so one slow group (e.g. a /proc walk over tens of thousands of PIDs) does not delay the others. Queued
+ * runs are served by priority, FIFO within a priority. Each run carries the deadline it has to finish by; runs that
+ * finish late are counted per group rather than silently publishing samples with skewed timestamps.
+ *
+ * Groups that can block in the kernel (statvfs on a stalled network mount, a misbehaving hwmon driver) run on a
+ * sacrificial thread instead, and the worker waits for them only up to the collector timeout. A run that times out is
+ * abandoned: its series are marked stale, anything it publishes afterwards is discarded, and no second run starts
+ * while the first call is still stuck.
+ *
+ * A group whose update function fails or times out backs off exponentially (2, 4, 8... intervals, capped) instead of
+ * retrying a missing sysfs path every tick; the first successful run resets it.
+ *
+ * @date 16/10/2026
+ * @author 1v6n
+ */
+
+#include "expose_metrics.h"
+#include <time.h>
+
+#define WORKER_POOL_DEFAULT_SIZE 4           /**< Number of worker threads when none is configured. */
+#define WORKER_POOL_MAX_SIZE 64              /**< Upper bound on the number of worker threads. */
+#define WORKER_POOL_DEFAULT_TIMEOUT_MS 2000U /**< Collector timeout when none is configured. */
+#define WORKER_POOL_MAX_BACKOFF_SHIFT 6      /**< Backoff stops doubling after 2^6 intervals. */
+#define WORKER_POOL_MAX_BACKOFF_MS 300000ULL /**< Upper bound on the backoff after a failure. */
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param num_workers Number of worker threads, clamped to 1..WORKER_POOL_MAX_SIZE.
+ * @return 0 on success, or -1 if no thread could be created.
+ */
+int worker_pool_start(size_t num_workers);
+
+/**
+ * @brief Queues a run of a collector group.
+ *
+ * A group has at most one run queued or in progress. Submitting a group whose previous run has not finished yet is
+ * rejected and counted as a skipped run, as is submitting a blocking group whose abandoned run is still stuck. While
+ * a group backs off after a failure, submissions are dropped silently.
+ *
+ * @param group The group to run.
+ * @param deadline Absolute CLOCK_MONOTONIC time by which the run should have finished.
+ * @return true if the run was queued, false if it was skipped.
+ */
+bool worker_pool_submit(CollectorGroup* group, const struct timespec* deadline);
+
+/**
+ * @brief Waits until a group has no run queued or in progress.
+ *
+ * A blocking group's run is waited for only up to the collector timeout. Returns at once if the pool is stopping.
+ *
+ * @param group The group to wait for.
+ */
+void worker_pool_wait(const CollectorGroup* group);
+
+/**
+ * @brief Sets how long a run of a blocking group may take before it is abandoned.
+ *
+ * @param timeout_ms The timeout in milliseconds, or 0 for WORKER_POOL_DEFAULT_TIMEOUT_MS.
+ */
+void worker_pool_set_timeout(unsigned int timeout_ms);
+
+/**
+ * @brief Checks whether the calling thread is running a group run that has already timed out.
+ *
+ * Used to discard the results of an abandoned run that eventually returned.
+ *
+ * @return true if the results of the current run must be discarded.
+ */
+bool worker_run_abandoned(void);
+
+/**
+ * @brief Stops the worker threads after the runs in progress have finished. Queued runs are dropped.
+ */
+void worker_pool_stop(void);
+
+#endif // WORKER_POOL_H
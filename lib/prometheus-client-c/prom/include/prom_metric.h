@@ -48,6 +48,20 @@ typedef struct prom_metric prom_metric_t;
  */
 prom_metric_sample_t *prom_metric_sample_from_labels(prom_metric_t *self, const char **label_values);
 
+/**
+ * @brief Removes the sample with the given label values, so it is no longer exposed. The order of label_values is
+ * significant.
+ *
+ * A later update with the same label values creates the sample again, starting from 0. Samples previously returned
+ * by prom_metric_sample_from_labels() for these label values must not be used afterwards.
+ *
+ * @param self The target prom_metric_t*
+ * @param label_values The label values of the sample to remove. The number of labels must match the value passed to
+ *                     label_key_count in the metric's constructor.
+ * @return A non-zero integer value upon failure. Removing a sample that does not exist is not a failure.
+ */
+int prom_metric_sample_remove(prom_metric_t *self, const char **label_values);
+
 /**
  * @brief Returns a prom_metric_sample_histogram_t*. The order of label_values is significant.
  *
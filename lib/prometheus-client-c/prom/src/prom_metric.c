@@ -185,6 +185,34 @@ prom_metric_sample_t *prom_metric_sample_from_labels(prom_metric_t *self, const
   return sample;
 }
 
+int prom_metric_sample_remove(prom_metric_t *self, const char **label_values) {
+  PROM_ASSERT(self != NULL);
+  int r = 0;
+  r = pthread_rwlock_wrlock(self->rwlock);
+  if (r) {
+    PROM_LOG(PROM_PTHREAD_RWLOCK_LOCK_ERROR);
+    return r;
+  }
+
+  r = prom_metric_formatter_load_l_value(self->formatter, self->name, NULL, self->label_key_count, self->label_keys,
+                                         label_values);
+  const char *l_value = r ? NULL : prom_metric_formatter_dump(self->formatter);
+  if (l_value == NULL) {
+    r = 1;
+  } else {
+    // Deleting an absent sample is not an error
+    r = prom_map_delete(self->samples, l_value);
+    prom_free((void *)l_value);
+  }
+
+  int rr = pthread_rwlock_unlock(self->rwlock);
+  if (rr) {
+    PROM_LOG(PROM_PTHREAD_RWLOCK_UNLOCK_ERROR);
+    return rr;
+  }
+  return r;
+}
+
 prom_metric_sample_histogram_t *prom_metric_sample_histogram_from_labels(prom_metric_t *self,
                                                                          const char **label_values) {
   PROM_ASSERT(self != NULL);
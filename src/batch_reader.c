@@ -0,0 +1,386 @@
+/**
+ * @file batch_reader.c
+ * @brief Batched procfs reads through io_uring with registered buffers and fixed files.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "batch_reader.h"
+#include "logger.h"
+#include "proc_parse.h"
+#include "reader_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#define BATCH_PATH_SIZE 256 /**< Maximum length of a batched path. */
+
+/**
+ * @brief Structure to hold one file read in batches.
+ *
+ * The slot index doubles as the index of the file in the registered file table and of its registered buffer.
+ */
+typedef struct
+{
+    char path[BATCH_PATH_SIZE]; /**< Path the descriptor was opened from. */
+    unsigned int hash;          /**< Hash of path, compared before the string. */
+    int fd;                     /**< Open descriptor, or -1 until the next prefetch reopens it. */
+    char* buffer;               /**< Registered buffer of the slot. */
+    size_t length;              /**< Number of valid bytes in buffer when ready. */
+    bool ready;                 /**< Whether buffer holds contents not taken yet. */
+    bool in_flight;             /**< Whether a read into buffer is queued in the kernel. */
+} BatchSlot;
+
+static BatchSlot slots[BATCH_READER_MAX_FILES];                /**< Batched files. */
+static size_t slot_count = 0;                                  /**< Number of used slots. */
+static pthread_mutex_t slots_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects slots and slot_count. */
+static atomic_bool enabled = false;                            /**< Whether the ring was set up. */
+static atomic_ullong enter_calls = 0;                          /**< io_uring_enter() calls so far. */
+
+/**
+ * @brief Finds the slot of a path. Called with slots_lock held.
+ *
+ * @return The slot, or NULL if the path has none.
+ */
+static BatchSlot* find_slot(const char* path, unsigned int hash)
+{
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (slots[i].hash == hash && strcmp(slots[i].path, path) == 0)
+        {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+#ifdef HAVE_IO_URING
+
+/**
+ * @brief Structure to hold the mapped submission and completion rings.
+ */
+typedef struct
+{
+    int fd;                    /**< io_uring instance. */
+    unsigned* sq_tail;         /**< Submission queue tail, written by us. */
+    unsigned* sq_mask;         /**< Submission queue index mask. */
+    unsigned* sq_array;        /**< Submission queue index array. */
+    struct io_uring_sqe* sqes; /**< Submission queue entries. */
+    unsigned* cq_head;         /**< Completion queue head, written by us. */
+    unsigned* cq_tail;         /**< Completion queue tail, written by the kernel. */
+    unsigned* cq_mask;         /**< Completion queue index mask. */
+    struct io_uring_cqe* cqes; /**< Completion queue entries. */
+} Ring;
+
+static Ring ring = {.fd = -1}; /**< The io_uring instance, used by the scheduler thread only. */
+static char* arena = NULL;     /**< Registered buffers of all slots. */
+
+/**
+ * @brief Points the registered file table entry of a slot at its current descriptor.
+ */
+static int update_fixed_file(size_t index, int fd)
+{
+    struct io_uring_files_update update = {.offset = (unsigned)index, .fds = (unsigned long)&fd};
+    return syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_FILES_UPDATE, &update, 1) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Maps the rings of a new io_uring instance.
+ */
+static int map_ring(const struct io_uring_params* params)
+{
+    size_t sq_size = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+    size_t cq_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params->features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && cq_size > sq_size)
+    {
+        sq_size = cq_size;
+    }
+
+    char* sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+    {
+        return -1;
+    }
+    char* cq = sq;
+    if (!single_mmap)
+    {
+        cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+        {
+            return -1;
+        }
+    }
+    ring.sqes = mmap(NULL, params->sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    ring.sq_tail = (unsigned*)(sq + params->sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params->sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params->sq_off.array);
+    ring.cq_head = (unsigned*)(cq + params->cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params->cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params->cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params->cq_off.cqes);
+    return 0;
+}
+
+/**
+ * @brief Closes a partially set up io_uring instance; its mappings go away with the descriptor.
+ */
+static int abandon_ring(void)
+{
+    close(ring.fd);
+    ring.fd = -1;
+    free(arena);
+    arena = NULL;
+    return -1;
+}
+
+int batch_reader_init(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring.fd = (int)syscall(__NR_io_uring_setup, BATCH_READER_QUEUE_DEPTH, &params);
+    if (ring.fd < 0)
+    {
+        return -1;
+    }
+
+    arena = aligned_alloc(4096, (size_t)BATCH_READER_MAX_FILES * BATCH_READER_BUFFER_SIZE);
+    if (arena == NULL || map_ring(&params) != 0)
+    {
+        return abandon_ring();
+    }
+
+    // One registered buffer per slot, and a sparse table of fixed files filled in as files are added
+    struct iovec iovecs[BATCH_READER_MAX_FILES];
+    int fds[BATCH_READER_MAX_FILES];
+    for (size_t i = 0; i < BATCH_READER_MAX_FILES; i++)
+    {
+        slots[i].buffer = arena + i * BATCH_READER_BUFFER_SIZE;
+        iovecs[i] = (struct iovec){slots[i].buffer, BATCH_READER_BUFFER_SIZE};
+        fds[i] = -1;
+    }
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, iovecs, BATCH_READER_MAX_FILES) < 0 ||
+        syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_FILES, fds, BATCH_READER_MAX_FILES) < 0)
+    {
+        return abandon_ring();
+    }
+
+    atomic_store(&enabled, true);
+    return 0;
+}
+
+/**
+ * @brief Finds or creates the slot of a path and makes sure it has an open, registered descriptor.
+ *
+ * @return The slot, or NULL if the table is full or the file cannot be opened.
+ */
+static BatchSlot* prepare_slot(const char* path)
+{
+    unsigned int hash = parse_hash(path, strlen(path));
+
+    pthread_mutex_lock(&slots_lock);
+    BatchSlot* slot = find_slot(path, hash);
+    if (slot == NULL && slot_count < BATCH_READER_MAX_FILES && strlen(path) < BATCH_PATH_SIZE)
+    {
+        slot = &slots[slot_count++];
+        strcpy(slot->path, path);
+        slot->hash = hash;
+        slot->fd = -1;
+    }
+    if (slot == NULL || slot->in_flight)
+    {
+        // Full, or listed twice in the same batch
+        pthread_mutex_unlock(&slots_lock);
+        return NULL;
+    }
+    pthread_mutex_unlock(&slots_lock);
+
+    // Only this thread opens and registers descriptors, so this needs no lock
+    if (slot->fd < 0)
+    {
+        slot->fd = reader_open(path);
+        if (slot->fd < 0)
+        {
+            return NULL;
+        }
+        if (update_fixed_file((size_t)(slot - slots), slot->fd) != 0)
+        {
+            close(slot->fd);
+            slot->fd = -1;
+            return NULL;
+        }
+    }
+    return slot;
+}
+
+void batch_reader_prefetch(const char* paths[], size_t num_paths)
+{
+    if (!atomic_load(&enabled))
+    {
+        return;
+    }
+
+    size_t count = 0;
+    unsigned tail = *ring.sq_tail;
+    for (size_t i = 0; i < num_paths && count < BATCH_READER_MAX_FILES; i++)
+    {
+        BatchSlot* slot = prepare_slot(paths[i]);
+        if (slot == NULL)
+        {
+            continue;
+        }
+
+        // Once in flight the buffer is not handed out until the read completes
+        pthread_mutex_lock(&slots_lock);
+        slot->ready = false;
+        slot->in_flight = true;
+        pthread_mutex_unlock(&slots_lock);
+
+        size_t index = (size_t)(slot - slots);
+        unsigned sq_index = tail & *ring.sq_mask;
+        struct io_uring_sqe* sqe = &ring.sqes[sq_index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->flags = IOSQE_FIXED_FILE;
+        sqe->fd = (int)index;
+        sqe->addr = (unsigned long)slot->buffer;
+        sqe->len = BATCH_READER_BUFFER_SIZE - 1;
+        sqe->off = 0;
+        sqe->buf_index = (unsigned short)index;
+        sqe->user_data = index;
+        ring.sq_array[sq_index] = sq_index;
+        tail++;
+        count++;
+    }
+    if (count == 0)
+    {
+        return;
+    }
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+    // Submit the whole batch and wait for all of it in one call
+    size_t completed = 0;
+    int submitted = 0;
+    while (completed < count)
+    {
+        int rc = (int)syscall(__NR_io_uring_enter, ring.fd, (unsigned)(count - (size_t)submitted),
+                              (unsigned)(count - completed), IORING_ENTER_GETEVENTS, NULL, 0);
+        atomic_fetch_add_explicit(&enter_calls, 1, memory_order_relaxed);
+        if (rc < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if (rc > 0)
+        {
+            submitted += rc;
+        }
+
+        unsigned head = *ring.cq_head;
+        pthread_mutex_lock(&slots_lock);
+        while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE))
+        {
+            const struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+            BatchSlot* slot = &slots[cqe->user_data];
+            slot->in_flight = false;
+            if (cqe->res >= 0 && cqe->res < BATCH_READER_BUFFER_SIZE - 1)
+            {
+                slot->length = (size_t)cqe->res;
+                slot->buffer[slot->length] = '\0';
+                slot->ready = true;
+            }
+            else if (cqe->res == -ENODEV || cqe->res == -ENOENT || cqe->res == -ESTALE)
+            {
+                // The file went away; reopen it on the next prefetch
+                close(slot->fd);
+                slot->fd = -1;
+            }
+            head++;
+            completed++;
+        }
+        pthread_mutex_unlock(&slots_lock);
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    if (completed < count)
+    {
+        // io_uring_enter() failed; leave everything to the pread() path from now on
+        LOG_MESSAGE("io_uring_enter failed, falling back to pread\n");
+        atomic_store(&enabled, false);
+    }
+}
+
+#else
+
+int batch_reader_init(void)
+{
+    return -1;
+}
+
+void batch_reader_prefetch(const char* paths[], size_t num_paths)
+{
+    (void)paths;
+    (void)num_paths;
+}
+
+#endif // HAVE_IO_URING
+
+bool batch_reader_enabled(void)
+{
+    return atomic_load(&enabled);
+}
+
+ssize_t batch_reader_take(const char* path, char** buffer, size_t* capacity, bool growable)
+{
+    if (!atomic_load(&enabled))
+    {
+        return -1;
+    }
+
+    ssize_t length = -1;
+    pthread_mutex_lock(&slots_lock);
+    BatchSlot* slot = find_slot(path, parse_hash(path, strlen(path)));
+    if (slot != NULL && slot->ready)
+    {
+        if (growable && *capacity < slot->length + 1)
+        {
+            char* grown = realloc(*buffer, slot->length + 1);
+            if (grown != NULL)
+            {
+                *buffer = grown;
+                *capacity = slot->length + 1;
+            }
+        }
+        if (*capacity >= slot->length + 1)
+        {
+            memcpy(*buffer, slot->buffer, slot->length + 1);
+            length = (ssize_t)slot->length;
+            slot->ready = false;
+        }
+    }
+    pthread_mutex_unlock(&slots_lock);
+
+    return length;
+}
+
+unsigned long long batch_reader_enter_calls(void)
+{
+    return atomic_load_explicit(&enter_calls, memory_order_relaxed);
+}
@@ -0,0 +1,393 @@
+/**
+ * @file capture.c
+ * @brief Append-only capture of procfs/sysfs reads, and their replay through the reader cache.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "capture.h"
+#include "proc_parse.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CAPTURE_MAGIC_SIZE (sizeof(CAPTURE_MAGIC) - 1) /**< Length of the magic, without the terminator. */
+#define CAPTURE_HEADER_SIZE 15                          /**< Bytes of a record header: type, tick, lengths. */
+#define CAPTURE_READ 'R'                                /**< Record type of a read. */
+#define CAPTURE_GROUP 'G'                               /**< Record type of a group run; the path is the group. */
+#define CAPTURE_NONE SIZE_MAX                           /**< End of a chain of reads. */
+
+/**
+ * @brief Structure to hold one record of a loaded capture.
+ */
+typedef struct
+{
+    unsigned long long tick; /**< Tick of the group run the record belongs to. */
+    const char* path;        /**< Path read or group run, NUL-terminated inside the mapping. */
+    const char* data;        /**< Bytes read. */
+    int data_length;         /**< Number of bytes read, or -errno of a failed read. */
+    size_t next;             /**< Next read of the same path in the same tick, or CAPTURE_NONE. */
+} CaptureRecord;
+
+/**
+ * @brief Structure to hold one slot of the replay index, keyed by tick and path.
+ */
+typedef struct
+{
+    const CaptureRecord* key; /**< First record with this tick and path, or NULL if the slot is free. */
+    size_t head;              /**< Next unconsumed read of the chain, or CAPTURE_NONE. */
+    size_t tail;              /**< Last read of the chain, while the index is built. */
+} ReplaySlot;
+
+static atomic_bool recording = false;                           /**< Whether reads are being recorded. */
+static FILE* record_file;                                       /**< Capture file being written. */
+static char* record_buffer;                                     /**< stdio buffer of record_file. */
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER; /**< Serializes appends to record_file. */
+static _Thread_local unsigned long long thread_tick;            /**< Tick of the group run on this thread. */
+
+static bool replaying = false;         /**< Whether reads are served from the capture. */
+static void* replay_mapping;           /**< The capture file, mapped read-only. */
+static size_t replay_mapping_size;     /**< Size of replay_mapping. */
+static CaptureRecord* records;         /**< Reads of the capture, in file order. */
+static ReplaySlot* replay_index;       /**< Open-addressing index of records by tick and path. */
+static size_t replay_index_mask;       /**< Number of index slots minus one. */
+static CaptureRecord* group_runs;      /**< Group runs, ordered by tick and then by file order. */
+static size_t group_run_count;         /**< Number of entries in group_runs. */
+static size_t replay_position;         /**< Next entry of group_runs to replay. */
+static unsigned long long replay_tick; /**< Tick being replayed. */
+static bool replay_started = false;    /**< Whether capture_replay_next_tick() was called. */
+
+/**
+ * @brief Appends one record to the capture file. Called with record_lock held.
+ */
+static void write_record(char type, unsigned long long tick, const char* path, const char* data, int data_length)
+{
+    unsigned char header[CAPTURE_HEADER_SIZE];
+    uint16_t path_length = (uint16_t)(strlen(path) + 1);
+    int32_t length = data_length;
+    header[0] = (unsigned char)type;
+    memcpy(header + 1, &tick, sizeof(tick));
+    memcpy(header + 9, &path_length, sizeof(path_length));
+    memcpy(header + 11, &length, sizeof(length));
+
+    fwrite(header, 1, sizeof(header), record_file);
+    fwrite(path, 1, path_length, record_file);
+    if (data_length > 0)
+    {
+        fwrite(data, 1, (size_t)data_length, record_file);
+    }
+}
+
+int capture_record_start(const char* path)
+{
+    record_file = fopen(path, "wb");
+    if (record_file == NULL)
+    {
+        return -1;
+    }
+    record_buffer = malloc(CAPTURE_BUFFER_SIZE);
+    if (record_buffer != NULL)
+    {
+        setvbuf(record_file, record_buffer, _IOFBF, CAPTURE_BUFFER_SIZE);
+    }
+    fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, record_file);
+    atomic_store(&recording, true);
+    return 0;
+}
+
+bool capture_recording(void)
+{
+    return atomic_load_explicit(&recording, memory_order_relaxed);
+}
+
+bool capture_replaying(void)
+{
+    return replaying;
+}
+
+void capture_begin_group(const char* group, unsigned long long tick)
+{
+    if (!capture_recording())
+    {
+        return;
+    }
+    thread_tick = tick;
+    pthread_mutex_lock(&record_lock);
+    write_record(CAPTURE_GROUP, tick, group, NULL, 0);
+    pthread_mutex_unlock(&record_lock);
+}
+
+void capture_end_group(void)
+{
+    if (!capture_recording())
+    {
+        return;
+    }
+    // Flushing per run keeps the capture usable up to the last complete run if the exporter is killed
+    pthread_mutex_lock(&record_lock);
+    fflush(record_file);
+    pthread_mutex_unlock(&record_lock);
+}
+
+void capture_record_read(const char* path, const char* data, ssize_t length)
+{
+    if (!capture_recording())
+    {
+        return;
+    }
+    int saved_errno = errno;
+    pthread_mutex_lock(&record_lock);
+    write_record(CAPTURE_READ, thread_tick, path, data, length >= 0 ? (int)length : -saved_errno);
+    pthread_mutex_unlock(&record_lock);
+    errno = saved_errno;
+}
+
+/**
+ * @brief Finds the index slot of a tick and path: the slot holding them, or the free slot where they belong.
+ */
+static ReplaySlot* find_slot(unsigned long long tick, const char* path)
+{
+    size_t hash = parse_hash(path, strlen(path)) ^ (size_t)(tick * 0x9e3779b97f4a7c15ULL);
+    for (size_t i = hash & replay_index_mask;; i = (i + 1) & replay_index_mask)
+    {
+        ReplaySlot* slot = &replay_index[i];
+        if (slot->key == NULL || (slot->key->tick == tick && strcmp(slot->key->path, path) == 0))
+        {
+            return slot;
+        }
+    }
+}
+
+/**
+ * @brief Orders group runs by tick; runs of the same tick keep their file order.
+ */
+static int compare_group_runs(const void* a, const void* b)
+{
+    const CaptureRecord* x = a;
+    const CaptureRecord* y = b;
+    if (x->tick != y->tick)
+    {
+        return x->tick < y->tick ? -1 : 1;
+    }
+    return (x->path > y->path) - (x->path < y->path); // Paths point into the mapping, so this is file order
+}
+
+/**
+ * @brief Walks the records of the mapped capture, stopping at the first truncated one.
+ *
+ * @param reads Array receiving the reads, or NULL to only count them.
+ * @param runs Array receiving the group runs, or NULL to only count them.
+ * @param num_reads Pointer to store the number of reads.
+ * @param num_runs Pointer to store the number of group runs.
+ */
+static void scan_records(CaptureRecord* reads, CaptureRecord* runs, size_t* num_reads, size_t* num_runs)
+{
+    const char* cursor = (const char*)replay_mapping + CAPTURE_MAGIC_SIZE;
+    const char* end = (const char*)replay_mapping + replay_mapping_size;
+    *num_reads = 0;
+    *num_runs = 0;
+    while ((size_t)(end - cursor) >= CAPTURE_HEADER_SIZE)
+    {
+        CaptureRecord record;
+        uint16_t path_length;
+        int32_t data_length;
+        char type = cursor[0];
+        memcpy(&record.tick, cursor + 1, sizeof(record.tick));
+        memcpy(&path_length, cursor + 9, sizeof(path_length));
+        memcpy(&data_length, cursor + 11, sizeof(data_length));
+        size_t payload = path_length + (data_length > 0 ? (size_t)data_length : 0);
+        cursor += CAPTURE_HEADER_SIZE;
+        if (path_length == 0 || (size_t)(end - cursor) < payload || cursor[path_length - 1] != '\0')
+        {
+            break;
+        }
+
+        record.path = cursor;
+        record.data = cursor + path_length;
+        record.data_length = data_length;
+        record.next = CAPTURE_NONE;
+        cursor += payload;
+        if (type == CAPTURE_GROUP)
+        {
+            if (runs != NULL)
+            {
+                runs[*num_runs] = record;
+            }
+            (*num_runs)++;
+        }
+        else if (type == CAPTURE_READ)
+        {
+            if (reads != NULL)
+            {
+                reads[*num_reads] = record;
+            }
+            (*num_reads)++;
+        }
+    }
+}
+
+int capture_replay_open(const char* path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < CAPTURE_MAGIC_SIZE)
+    {
+        close(fd);
+        return -1;
+    }
+    replay_mapping_size = (size_t)info.st_size;
+    replay_mapping = mmap(NULL, replay_mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (replay_mapping == MAP_FAILED || memcmp(replay_mapping, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE) != 0)
+    {
+        if (replay_mapping != MAP_FAILED)
+        {
+            munmap(replay_mapping, replay_mapping_size);
+        }
+        replay_mapping = NULL;
+        return -1;
+    }
+
+    size_t num_reads, num_runs;
+    scan_records(NULL, NULL, &num_reads, &num_runs);
+    size_t slots = 16;
+    while (slots < num_reads * 2)
+    {
+        slots *= 2;
+    }
+    records = malloc((num_reads + 1) * sizeof(CaptureRecord));
+    group_runs = malloc((num_runs + 1) * sizeof(CaptureRecord));
+    replay_index = calloc(slots, sizeof(ReplaySlot));
+    if (records == NULL || group_runs == NULL || replay_index == NULL)
+    {
+        capture_close();
+        return -1;
+    }
+    replay_index_mask = slots - 1;
+    scan_records(records, group_runs, &num_reads, &group_run_count);
+
+    // Chain the reads of each tick and path in file order, so repeated reads are served in the order they were made
+    for (size_t i = 0; i < num_reads; i++)
+    {
+        ReplaySlot* slot = find_slot(records[i].tick, records[i].path);
+        if (slot->key == NULL)
+        {
+            slot->key = &records[i];
+            slot->head = i;
+        }
+        else
+        {
+            records[slot->tail].next = i;
+        }
+        slot->tail = i;
+    }
+    qsort(group_runs, group_run_count, sizeof(CaptureRecord), compare_group_runs);
+
+    replay_position = 0;
+    replay_started = false;
+    replaying = true;
+    return 0;
+}
+
+ssize_t capture_replay_read(const char* path, char** buffer, size_t* capacity, bool growable)
+{
+    ReplaySlot* slot = find_slot(replay_tick, path);
+    if (slot->key == NULL || slot->head == CAPTURE_NONE)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+    const CaptureRecord* record = &records[slot->head];
+    slot->head = record->next;
+    if (record->data_length < 0)
+    {
+        errno = -record->data_length;
+        return -1;
+    }
+
+    size_t length = (size_t)record->data_length;
+    if (growable && *capacity < length + 1)
+    {
+        char* grown = realloc(*buffer, length + 1);
+        if (grown == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        *buffer = grown;
+        *capacity = length + 1;
+    }
+    if (*capacity == 0)
+    {
+        return 0;
+    }
+    length = length < *capacity - 1 ? length : *capacity - 1;
+    memcpy(*buffer, record->data, length);
+    (*buffer)[length] = '\0';
+    return (ssize_t)length;
+}
+
+bool capture_replay_next_tick(void)
+{
+    if (replay_started)
+    {
+        while (replay_position < group_run_count && group_runs[replay_position].tick == replay_tick)
+        {
+            replay_position++;
+        }
+    }
+    replay_started = true;
+    if (replay_position == group_run_count)
+    {
+        return false;
+    }
+    replay_tick = group_runs[replay_position].tick;
+    return true;
+}
+
+const char* capture_replay_next_group(void)
+{
+    if (replay_position < group_run_count && group_runs[replay_position].tick == replay_tick)
+    {
+        return group_runs[replay_position++].path;
+    }
+    return NULL;
+}
+
+void capture_close(void)
+{
+    if (atomic_exchange(&recording, false))
+    {
+        pthread_mutex_lock(&record_lock);
+        fclose(record_file);
+        record_file = NULL;
+        pthread_mutex_unlock(&record_lock);
+        free(record_buffer);
+        record_buffer = NULL;
+    }
+
+    replaying = false;
+    free(records);
+    free(group_runs);
+    free(replay_index);
+    records = NULL;
+    group_runs = NULL;
+    replay_index = NULL;
+    if (replay_mapping != NULL)
+    {
+        munmap(replay_mapping, replay_mapping_size);
+        replay_mapping = NULL;
+    }
+}
@@ -6,18 +6,119 @@
  * memory usage, disk stats, and network traffic via Prometheus gauges. These metrics are collected from the
  * system and exposed through an HTTP server for monitoring purposes.
  *
- * The metrics include usage statistics for CPU, memory, disk, network, battery, and more,
- * and are safely updated in a multi-threaded environment using mutexes.
+ * The metrics include usage statistics for CPU, memory, disk, network, battery, and more. A collector run stages
+ * its values in a batch of its own and swaps it in atomically; scrapes apply and render the newest batch of each
+ * group, so they only ever see complete generations and no lock is shared between collectors.
  *
  * @author 1v6n
  * @date 09/10/2024
  */
 
 #include "expose_metrics.h"
+#include "capture.h"
+#include "interface_filter.h"
+#include "logger.h"
+#include "netlink_stats.h"
+#include "worker_pool.h"
+#include <math.h>
+#include <microhttpd.h>
+#include <stdatomic.h>
 #define METRICS_FILE "/tmp/monitor_metrics"
+#define GENERATION_TRAILER_SIZE 160 /**< Room for the metrics_generation family appended to each scrape. */
+#define SLOT_INDEX_MASK 3u          /**< Bits of a group's exchange word holding a slot index. */
+#define SLOT_FRESH 4u               /**< Set in the exchange word while the slot there holds an unread batch. */
+#define STAGED_MAX_LABELS 2         /**< Maximum number of labels of a staged value. */
 
-bool keep_running = true; /**< Control variable for the main loop. */
-pthread_mutex_t lock;     /**< Mutex for thread synchronization. */
+/**
+ * @brief Structure to hold a value staged by a collector run until the run publishes.
+ */
+typedef struct
+{
+    prom_gauge_t* metric;                              /**< The gauge to set. */
+    double value;                                      /**< The value to set. */
+    size_t label_count;                                /**< Number of label values, 0 for a plain gauge. */
+    char labels[STAGED_MAX_LABELS][MEMINFO_NAME_SIZE]; /**< Label values, copied as the source is transient. */
+} StagedValue;
+
+/**
+ * @brief Structure to hold an interface whose series are to be deleted.
+ */
+typedef struct
+{
+    char name[INTERFACE_NAME_SIZE]; /**< Interface name. */
+    unsigned long generation;       /**< Publish generation when the link went away; later batches do not list it. */
+} InterfaceRemoval;
+
+/**
+ * @brief Structure to hold every value published by one collector group run.
+ */
+typedef struct
+{
+    StagedValue* values;      /**< Staged values in the order they were set, grown by the run that owns the batch. */
+    size_t count;             /**< Number of valid entries in values. */
+    size_t capacity;          /**< Number of entries allocated in values. */
+    unsigned long generation; /**< Publish generation the batch was stamped with. */
+} PublishBatch;
+
+/**
+ * @brief Structure to hold the batches of a collector group (a lock-free triple buffer).
+ *
+ * The group's run fills the back batch and swaps it into the exchange word; the scrape renderer swaps the exchange
+ * word with its front batch when it is flagged fresh. Each side owns its own batch outright, so neither ever waits for
+ * the other. There is a single writer per group since the worker pool never runs a group twice at once.
+ */
+typedef struct
+{
+    PublishBatch batches[3];                  /**< Back, exchange and front batches, in no fixed order. */
+    atomic_uint exchange;                     /**< Batch between the two sides, with SLOT_FRESH when unread. */
+    unsigned int back;                        /**< Index of the batch being filled, owned by the group's run. */
+    unsigned int front;                       /**< Index of the batch last applied, owned by the scrape renderer. */
+    bool front_stale;                         /**< Whether the renderer last exposed the group as stale. */
+    double previous[ADAPTIVE_TRACKED_VALUES]; /**< Unlabeled values of the previous run, owned by the group's run. */
+    size_t previous_count;                    /**< Number of valid entries in previous. */
+} GroupBuffer;
+
+/**
+ * @brief Structure to hold the sample ring and the aggregate families of one series.
+ */
+typedef struct
+{
+    CollectorGroupId group;                                     /**< Group that publishes the series. */
+    prom_gauge_t* source;                                       /**< Gauge of the instantaneous value. */
+    prom_gauge_t* min_metric;                                   /**< Gauge of the window minimum. */
+    prom_gauge_t* max_metric;                                   /**< Gauge of the window maximum. */
+    prom_gauge_t* avg_metric;                                   /**< Gauge of the window average. */
+    prom_gauge_t* quantile_metrics[SAMPLE_QUANTILE_COUNT];      /**< Gauges of the window quantiles. */
+    char names[3 + SAMPLE_QUANTILE_COUNT][AGGREGATE_NAME_SIZE]; /**< Names of the families, referenced by the gauges. */
+    SampleRing ring;                                            /**< Samples since the previous scrape. */
+} AggregateSeries;
+
+bool keep_running = true;               /**< Control variable for the main loop. */
+
+static GroupBuffer* group_buffers[GROUP_COUNT];                  /**< Batches of each enabled group. */
+static atomic_bool group_stale[GROUP_COUNT];                     /**< Whether each group's last run timed out. */
+static atomic_ulong publish_generation;                          /**< Generation stamped on the last published batch. */
+static unsigned long exposed_generation;                         /**< Newest generation applied by the renderer. */
+static pthread_mutex_t scrape_lock = PTHREAD_MUTEX_INITIALIZER;  /**< Serializes scrapes; never taken by collectors. */
+static _Thread_local GroupBuffer* current_buffer = NULL;         /**< Batches of the group running on this thread. */
+static double adaptive_threshold = 0;                            /**< Relative change counted as volatile, 0 if off. */
+static atomic_uint effective_interval_ms[GROUP_COUNT];           /**< Adaptive interval of each group, 0 until set. */
+static atomic_uint throttle_shift[GROUP_COUNT];                  /**< CPU budget throttle of each group, log2. */
+static atomic_ullong group_cpu_ns[GROUP_COUNT];                  /**< CPU time spent in each group's runs. */
+static atomic_ullong last_run_cpu_ns[GROUP_COUNT];               /**< CPU time of each group's last run. */
+static double cpu_budget = 0;                                    /**< Share of one core allowed, 0 if unlimited. */
+static unsigned long long governor_window_ms = 0;                /**< Start of the current budget window. */
+static unsigned long long governor_process_ns;                   /**< Process CPU time at the window start. */
+static unsigned long long governor_group_ns[GROUP_COUNT];        /**< group_cpu_ns at the window start. */
+static unsigned int lazy_max_age_ms = 0;                         /**< Max age of scrape-collected values, 0 when off. */
+static atomic_ullong last_run_ms[GROUP_COUNT];                   /**< When each group's last run ended, 0 if never. */
+static pthread_mutex_t collect_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects collecting and collect_round. */
+static pthread_cond_t collect_cond = PTHREAD_COND_INITIALIZER;   /**< Broadcast when a scrape-driven collection ends. */
+static bool collecting = false;                                  /**< Whether a scrape is collecting stale groups. */
+static unsigned long collect_round = 0;                          /**< Number of finished scrape-driven collections. */
+static AggregateSeries* aggregate_series[AGGREGATE_MAX_SERIES];  /**< Series with window aggregates. */
+static size_t aggregate_count = 0;                               /**< Number of valid entries in aggregate_series. */
+static bool group_aggregated[GROUP_COUNT];                       /**< Whether each group has aggregated series. */
 
 static prom_gauge_t* cpu_usage_metric;         /**< Prometheus gauge for tracking CPU usage. */
 static prom_gauge_t* memory_usage_metric;      /**< Prometheus gauge for tracking memory usage. */
@@ -47,240 +148,1522 @@ static prom_gauge_t* tx_bytes_metric;  /**< Prometheus gauge for tracking the to
 static prom_gauge_t* rx_errors_metric; /**< Prometheus gauge for tracking the total receive errors in the network. */
 static prom_gauge_t* tx_errors_metric; /**< Prometheus gauge for tracking the total transmit errors in the network. */
 static prom_gauge_t* dropped_packets_metric; /**< Prometheus gauge for tracking the total number of dropped packets. */
+static prom_gauge_t* interrupts_metric;      /**< Prometheus gauge for tracking the interrupts serviced since boot. */
+static prom_gauge_t* forks_metric;           /**< Prometheus gauge for tracking the processes forked since boot. */
+static prom_gauge_t* blocked_tasks_metric;   /**< Prometheus gauge for tracking the tasks blocked on I/O. */
+static prom_gauge_t* softirqs_metric;        /**< Prometheus gauge for tracking the softirqs serviced since boot. */
+static prom_gauge_t* syscalls_saved_metric;  /**< Prometheus gauge for tracking syscalls saved by the reader cache. */
+static prom_gauge_t* meminfo_kb_metric;      /**< Prometheus gauge family for every /proc/meminfo field in kB. */
+static prom_gauge_t* meminfo_pages_metric;   /**< Prometheus gauge family for the unitless /proc/meminfo fields. */
+static prom_gauge_t* cpu_seconds_metric;     /**< Prometheus gauge family for the time per core and mode. */
+static prom_gauge_t* core_usage_metric;      /**< Prometheus gauge family for the usage of each core. */
+static prom_gauge_t* window_usage_metric;    /**< Prometheus gauge family for the CPU usage over trailing windows. */
+
+static prom_gauge_t* interface_metrics[NET_DEV_COUNTERS]; /**< Prometheus gauge family per interface counter. */
+static InterfaceStats* interfaces = NULL;                 /**< Counters of the selected interfaces, grown to fit. */
+static size_t interfaces_capacity = 0;                    /**< Number of entries allocated in interfaces. */
+
+static InterfaceRemoval* interface_removals = NULL;              /**< Interfaces whose series await deletion. */
+static size_t interface_removal_count = 0;                       /**< Number of valid entries in interface_removals. */
+static size_t interface_removal_capacity = 0;                    /**< Number of entries allocated in removals. */
+static pthread_mutex_t removal_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects interface_removals. */
+
+static CoreTimes* cpu_cores = NULL;        /**< Per-core counters of the current run, grown to fit every core. */
+static size_t cpu_cores_capacity = 0;      /**< Number of entries allocated in cpu_cores. */
+static CoreTimes* previous_cores = NULL;   /**< Per-core counters of the previous run, swapped with cpu_cores. */
+static size_t previous_cores_capacity = 0; /**< Number of entries allocated in previous_cores. */
+static size_t previous_core_count = 0;     /**< Number of valid entries in previous_cores. */
+
+static prom_counter_t* collector_late_runs_metric;    /**< Prometheus counter of runs that missed their deadline. */
+static prom_counter_t* collector_skipped_runs_metric; /**< Prometheus counter of runs skipped while still running. */
+static prom_gauge_t* collector_duration_metric;       /**< Prometheus gauge of the last run duration per group. */
+static prom_counter_t* collector_timeouts_metric;     /**< Prometheus counter of runs abandoned after the timeout. */
+static prom_gauge_t* collector_stale_metric;          /**< Prometheus gauge set while a group's series are stale. */
+static prom_gauge_t* collector_up_metric;             /**< Prometheus gauge set while a group's runs succeed. */
+static prom_counter_t* collector_errors_metric;       /**< Prometheus counter of failed runs per group. */
+static bool collector_down[GROUP_COUNT];              /**< Whether the last run of each group failed. */
+static prom_histogram_t* tick_lateness_metric;        /**< Prometheus histogram of scheduler wakeup lateness. */
+static prom_counter_t* tick_overruns_metric;          /**< Prometheus counter of runs skipped after falling behind. */
+static prom_gauge_t* collector_interval_metric;       /**< Prometheus gauge of the effective interval per group. */
+static prom_counter_t* log_dropped_metric;            /**< Prometheus counter of log messages dropped when full. */
+static prom_counter_t* log_suppressed_metric;         /**< Prometheus counter of log messages suppressed as repeats. */
+static unsigned long long log_dropped_exposed;        /**< Dropped messages already added to log_dropped_metric. */
+static unsigned long long log_suppressed_exposed;     /**< Suppressed messages already added to the counter. */
+static prom_counter_t* collector_cpu_metric;          /**< Prometheus counter of CPU time per group. */
+static prom_gauge_t* cpu_usage_ratio_metric;          /**< Prometheus gauge of the exporter's CPU use per window. */
+static prom_gauge_t* cpu_budget_metric;               /**< Prometheus gauge of the configured CPU budget. */
+static prom_gauge_t* throttle_factor_metric;          /**< Prometheus gauge of each group's interval multiplier. */
+static prom_counter_t* throttle_decisions_metric;     /**< Prometheus counter of throttling decisions per group. */
+
+static const char* meminfo_label_keys[] = {"field"};                /**< Label keys of the /proc/meminfo families. */
+static const char* collector_label_keys[] = {"collector"};          /**< Label keys of the per-group self metrics. */
+static const char* throttle_label_keys[] = {"collector", "action"}; /**< Label keys of the throttling decisions. */
+static const char* cpu_mode_label_keys[] = {"cpu", "mode"};         /**< Label keys of the per-mode CPU times. */
+static const char* cpu_label_keys[] = {"cpu"};                      /**< Label keys of the per-core usage. */
+static const char* window_label_keys[] = {"window"};                /**< Label keys of the windowed CPU usage. */
+static const char* interface_label_keys[] = {"interface"};          /**< Label keys of the per-interface counters. */
+
+MetricInfo all_metrics[] = {
+    {"rx_bytes_total", "Total received bytes", &rx_bytes_metric, GROUP_NETWORK},
+    {"tx_bytes_total", "Total transmitted bytes", &tx_bytes_metric, GROUP_NETWORK},
+    {"rx_errors_total", "Total receive errors", &rx_errors_metric, GROUP_NETWORK},
+    {"tx_errors_total", "Total transmit errors", &tx_errors_metric, GROUP_NETWORK},
+    {"dropped_packets_total", "Total dropped packets", &dropped_packets_metric, GROUP_NETWORK},
+    {"network_receive_bytes_total", "Bytes received per interface", &interface_metrics[NET_RX_BYTES], GROUP_NETWORK,
+     1, interface_label_keys},
+    {"network_receive_packets_total", "Packets received per interface", &interface_metrics[NET_RX_PACKETS],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_receive_errs_total", "Receive errors per interface", &interface_metrics[NET_RX_ERRORS], GROUP_NETWORK,
+     1, interface_label_keys},
+    {"network_receive_drop_total", "Received packets dropped per interface", &interface_metrics[NET_RX_DROPPED],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_receive_fifo_total", "Receive FIFO overruns per interface", &interface_metrics[NET_RX_FIFO],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_receive_frame_total", "Receive framing errors per interface", &interface_metrics[NET_RX_FRAME],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_receive_compressed_total", "Compressed packets received per interface",
+     &interface_metrics[NET_RX_COMPRESSED], GROUP_NETWORK, 1, interface_label_keys},
+    {"network_receive_multicast_total", "Multicast frames received per interface", &interface_metrics[NET_RX_MULTICAST],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_bytes_total", "Bytes transmitted per interface", &interface_metrics[NET_TX_BYTES],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_packets_total", "Packets transmitted per interface", &interface_metrics[NET_TX_PACKETS],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_errs_total", "Transmit errors per interface", &interface_metrics[NET_TX_ERRORS], GROUP_NETWORK,
+     1, interface_label_keys},
+    {"network_transmit_drop_total", "Transmitted packets dropped per interface", &interface_metrics[NET_TX_DROPPED],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_fifo_total", "Transmit FIFO overruns per interface", &interface_metrics[NET_TX_FIFO],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_colls_total", "Collisions per interface", &interface_metrics[NET_TX_COLLISIONS], GROUP_NETWORK,
+     1, interface_label_keys},
+    {"network_transmit_carrier_total", "Carrier losses per interface", &interface_metrics[NET_TX_CARRIER],
+     GROUP_NETWORK, 1, interface_label_keys},
+    {"network_transmit_compressed_total", "Compressed packets transmitted per interface",
+     &interface_metrics[NET_TX_COMPRESSED], GROUP_NETWORK, 1, interface_label_keys},
+    {"io_time_ms", "Time spent on I/O in milliseconds", &io_time_metric, GROUP_DISK_STATS},
+    {"writes_completed_total", "Total writes completed", &writes_completed_metric, GROUP_DISK_STATS},
+    {"reads_completed_total", "Total reads completed", &reads_completed_metric, GROUP_DISK_STATS},
+    {"total_memory_mb", "Total memory in MB", &total_memory_metric, GROUP_MEMORY},
+    {"used_memory_mb", "Used memory in MB", &used_memory_metric, GROUP_MEMORY},
+    {"available_memory_mb", "Available memory in MB", &available_memory_metric, GROUP_MEMORY},
+    {"meminfo_kb", "Every /proc/meminfo field reported in kB", &meminfo_kb_metric, GROUP_MEMORY, 1, meminfo_label_keys},
+    {"meminfo_pages", "Every unitless /proc/meminfo field (HugePages_*)", &meminfo_pages_metric, GROUP_MEMORY, 1,
+     meminfo_label_keys},
+    {"context_switches", "Context switches", &context_switches_metric, GROUP_PROC_STAT},
+    {"interrupts_total", "Interrupts serviced since boot", &interrupts_metric, GROUP_PROC_STAT},
+    {"forks_total", "Processes forked since boot", &forks_metric, GROUP_PROC_STAT},
+    {"procs_blocked", "Tasks blocked waiting for I/O", &blocked_tasks_metric, GROUP_PROC_STAT},
+    {"softirqs_total", "Softirqs serviced since boot", &softirqs_metric, GROUP_PROC_STAT},
+    {"cpu_usage_percentage", "CPU usage in percentage", &cpu_usage_metric, GROUP_CPU},
+    {"cpu_seconds_total", "Seconds each core spent in each mode since boot", &cpu_seconds_metric, GROUP_CPU, 2,
+     cpu_mode_label_keys},
+    {"cpu_core_usage_percentage", "Usage of each core in percentage", &core_usage_metric, GROUP_CPU, 1,
+     cpu_label_keys},
+    {"cpu_usage_window_percentage",
+     "CPU usage in percentage over the trailing 1s, 10s, 1m and 5m, clamped to the history recorded since startup",
+     &window_usage_metric, GROUP_CPU, 1, window_label_keys},
+    {"memory_usage_percentage", "Memory usage in percentage", &memory_usage_metric, GROUP_MEMORY},
+    {"disk_usage_percentage", "Disk usage in percentage", &disk_usage_metric, GROUP_DISK_USAGE},
+    {"running_processes_total", "Total running processes", &running_processes_metric, GROUP_PROC_STAT},
+    {"cpu_temperature_celsius", "CPU temperature in Celsius", &cpu_temp_metric, GROUP_CPU_TEMPERATURE},
+    {"battery_voltage_volts", "Battery voltage in volts", &battery_voltage_metric, GROUP_BATTERY_VOLTAGE},
+    {"battery_current_amperes", "Battery current in amperes", &battery_current_metric, GROUP_BATTERY_CURRENT},
+    {"cpu_frequency_megahertz", "CPU frequency in MHz", &cpu_frequency_metric, GROUP_CPU_FREQUENCY},
+    {"cpu_fan_speed_rpm", "CPU fan speed in RPM", &cpu_fan_speed_metric, GROUP_CPU_FAN_SPEED},
+    {"gpu_fan_speed_rpm", "GPU fan speed in RPM", &gpu_fan_speed_metric, GROUP_GPU_FAN_SPEED},
+    {"total_processes", "Total number of processes", &total_processes_metric, GROUP_PROCESS_STATES},
+    {"suspended_processes", "Suspended processes", &suspended_processes_metric, GROUP_PROCESS_STATES},
+    {"ready_processes", "Ready processes", &ready_processes_metric, GROUP_PROCESS_STATES},
+    {"blocked_processes", "Blocked processes", &blocked_processes_metric, GROUP_PROCESS_STATES},
+    {"reader_syscalls_saved_total", "open()/close() syscalls saved by reusing cached descriptors",
+     &syscalls_saved_metric, GROUP_READER_CACHE},
+    {NULL, NULL, NULL} // Sentinel value to mark the end of the array
+};
+
+CollectorGroup all_groups[GROUP_COUNT] = {
+    [GROUP_CPU] = {"cpu", &update_cpu_group, 250, PRIORITY_HIGH, .files = {PROC_STAT_PATH}, .keeps_history = true,
+                   .min_interval_ms = 100, .max_interval_ms = 5000},
+    [GROUP_PROC_STAT] = {"proc_stat", &update_proc_stat_group, DEFAULT_INTERVAL_MS, PRIORITY_HIGH,
+                         .files = {PROC_STAT_PATH}},
+    [GROUP_MEMORY] = {"memory", &update_memory_group, DEFAULT_INTERVAL_MS, PRIORITY_HIGH, .files = {PROC_MEMINFO_PATH},
+                      .min_interval_ms = 250, .max_interval_ms = 10000},
+    [GROUP_DISK_USAGE] = {"disk_usage", &update_disk_gauge, 30000, PRIORITY_LOW, true, .min_interval_ms = 5000,
+                          .max_interval_ms = 120000},
+    [GROUP_DISK_STATS] = {"disk_stats", &update_disk_stats_metrics, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL,
+                          .files = {DISKSTATS_PATH}},
+    [GROUP_NETWORK] = {"network", &update_network_traffic_metric, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL,
+                       .files = {PROC_NET_DEV_PATH}},
+    [GROUP_PROCESS_STATES] = {"process_states", &update_process_states_gauge, 5000, PRIORITY_LOW},
+    [GROUP_CPU_TEMPERATURE] = {"cpu_temperature", &update_cpu_temperature, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL,
+                               true},
+    [GROUP_BATTERY_VOLTAGE] = {"battery_voltage", &update_battery_voltage, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL, true},
+    [GROUP_BATTERY_CURRENT] = {"battery_current", &update_battery_current, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL, true},
+    [GROUP_CPU_FREQUENCY] = {"cpu_frequency", &update_cpu_frequency, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL, true},
+    [GROUP_CPU_FAN_SPEED] = {"cpu_fan_speed", &update_cpu_fan_speed, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL, true},
+    [GROUP_GPU_FAN_SPEED] = {"gpu_fan_speed", &update_gpu_fan_speed, DEFAULT_INTERVAL_MS, PRIORITY_NORMAL,
+                             true},
+    [GROUP_READER_CACHE] = {"reader_cache", &update_reader_cache_metrics, 5000, PRIORITY_LOW},
+};
+
+static MetricInfo* metric_index[METRIC_INDEX_SIZE]; /**< Open-addressing hash index over all_metrics. */
+static bool metric_index_built = false;             /**< Whether metric_index has been filled. */
+
+/**
+ * @brief Fills the metric name hash index from all_metrics.
+ */
+static void build_metric_index(void)
+{
+    for (MetricInfo* info = all_metrics; info->name != NULL; info++)
+    {
+        size_t slot = parse_hash(info->name, strlen(info->name)) & (METRIC_INDEX_SIZE - 1);
+        while (metric_index[slot] != NULL)
+        {
+            slot = (slot + 1) & (METRIC_INDEX_SIZE - 1);
+        }
+        metric_index[slot] = info;
+    }
+    metric_index_built = true;
+}
+
+MetricInfo* find_metric(const char* name)
+{
+    if (!metric_index_built)
+    {
+        build_metric_index();
+    }
+
+    size_t slot = parse_hash(name, strlen(name)) & (METRIC_INDEX_SIZE - 1);
+    while (metric_index[slot] != NULL)
+    {
+        if (strcmp(metric_index[slot]->name, name) == 0)
+        {
+            return metric_index[slot];
+        }
+        slot = (slot + 1) & (METRIC_INDEX_SIZE - 1);
+    }
+    return NULL;
+}
+
+int set_group_intervals(const char* spec)
+{
+    char* spec_copy = strdup(spec);
+    if (spec_copy == NULL)
+    {
+        return RETURN_ERROR;
+    }
+
+    int result = 0;
+    char* saveptr = NULL;
+    for (char* entry = strtok_r(spec_copy, ",", &saveptr); entry != NULL; entry = strtok_r(NULL, ",", &saveptr))
+    {
+        char* separator = strchr(entry, '=');
+        if (separator == NULL)
+        {
+            fprintf(stderr, "Error: Invalid interval entry '%s'\n", entry);
+            result = RETURN_ERROR;
+            continue;
+        }
+        *separator = '\0';
+
+        // Either a fixed interval ("250") or the bounds of an adaptive one ("100:5000")
+        char* end = NULL;
+        unsigned long interval = strtoul(separator + 1, &end, 10);
+        bool valid = end != separator + 1 && interval > 0 && interval <= UINT_MAX;
+        unsigned long max_interval = 0;
+        if (valid && *end == ':')
+        {
+            const char* bound = end + 1;
+            max_interval = strtoul(bound, &end, 10);
+            valid = end != bound && max_interval >= interval && max_interval <= UINT_MAX;
+        }
+        if (!valid || *end != '\0')
+        {
+            fprintf(stderr, "Error: Invalid interval for group '%s'\n", entry);
+            result = RETURN_ERROR;
+            continue;
+        }
+
+        size_t i = 0;
+        while (i < GROUP_COUNT && strcmp(all_groups[i].name, entry) != 0)
+        {
+            i++;
+        }
+        if (i == GROUP_COUNT)
+        {
+            fprintf(stderr, "Error: Unknown collector group '%s'\n", entry);
+            result = RETURN_ERROR;
+            continue;
+        }
+        all_groups[i].interval_ms = (unsigned int)interval;
+        all_groups[i].min_interval_ms = max_interval > 0 ? (unsigned int)interval : 0;
+        all_groups[i].max_interval_ms = (unsigned int)max_interval;
+    }
+
+    free(spec_copy);
+    return result;
+}
+
+/**
+ * @brief Publishes the back batch of a group's run and takes another one to fill.
+ *
+ * Late results of a run that already timed out are discarded, and cleared so the next run does not publish them
+ * with its own; the group stays exposed as stale until a run succeeds.
+ */
+static void publish_batch(GroupBuffer* buffer)
+{
+    PublishBatch* batch = &buffer->batches[buffer->back];
+    if (worker_run_abandoned())
+    {
+        batch->count = 0;
+        return;
+    }
+    if (batch->count == 0)
+    {
+        return;
+    }
+
+    batch->generation = atomic_fetch_add_explicit(&publish_generation, 1, memory_order_relaxed) + 1;
+    unsigned int previous = atomic_exchange_explicit(&buffer->exchange, buffer->back | SLOT_FRESH,
+                                                     memory_order_acq_rel);
+    buffer->back = previous & SLOT_INDEX_MASK;
+    buffer->batches[buffer->back].count = 0;
+}
+
+/**
+ * @brief Stages a value of a gauge, or of one series of a labeled family when label_count is not 0.
+ *
+ * Outside a group run (nothing to batch with) the value is set at once. The back batch belongs to the run, so it can
+ * grow without the renderer noticing; a group with many series (one per core) sizes it on its first run.
+ */
+static void stage_labeled_value(prom_gauge_t* metric, const char* labels[], size_t label_count, double value)
+{
+    if (metric == NULL)
+    {
+        return; // Not selected
+    }
+
+    GroupBuffer* buffer = current_buffer;
+    if (buffer == NULL)
+    {
+        prom_gauge_set(metric, value, labels);
+        return;
+    }
+
+    PublishBatch* batch = &buffer->batches[buffer->back];
+    if (batch->count == batch->capacity)
+    {
+        size_t capacity = batch->capacity > 0 ? batch->capacity * 2 : PUBLISH_BATCH_SIZE;
+        StagedValue* grown = realloc(batch->values, capacity * sizeof(StagedValue));
+        if (grown == NULL)
+        {
+            // Keep the values rather than drop them, at the cost of splitting the run; an abandoned run's are cleared
+            publish_batch(buffer);
+            batch = &buffer->batches[buffer->back];
+            if (batch->count == batch->capacity)
+            {
+                return;
+            }
+        }
+        else
+        {
+            batch->values = grown;
+            batch->capacity = capacity;
+        }
+    }
+
+    StagedValue* staged = &batch->values[batch->count++];
+    staged->metric = metric;
+    staged->value = value;
+    staged->label_count = label_count < STAGED_MAX_LABELS ? label_count : STAGED_MAX_LABELS;
+    for (size_t i = 0; i < staged->label_count; i++)
+    {
+        snprintf(staged->labels[i], sizeof(staged->labels[i]), "%s", labels[i]);
+    }
+}
+
+/**
+ * @brief Stages a value of a gauge, or of one series of a single-label family when label is not NULL.
+ */
+static void stage_value(prom_gauge_t* metric, const char* label, double value)
+{
+    stage_labeled_value(metric, label != NULL ? (const char*[]){label} : NULL, label != NULL ? 1 : 0, value);
+}
+
+/**
+ * @brief Deletes the series of the removed interfaces that a batch about to be applied no longer lists. Called with
+ * scrape_lock held.
+ *
+ * Only batches stamped after a removal were collected without the interface; an older one may still list it and
+ * would bring the series back, so that removal waits for a newer batch.
+ */
+static void remove_interface_series(unsigned long generation)
+{
+    pthread_mutex_lock(&removal_lock);
+    size_t kept = 0;
+    for (size_t i = 0; i < interface_removal_count; i++)
+    {
+        const InterfaceRemoval* removal = &interface_removals[i];
+        if (removal->generation >= generation)
+        {
+            interface_removals[kept++] = *removal;
+            continue;
+        }
+#ifdef HAVE_PROM_SAMPLE_REMOVE
+        for (size_t counter = 0; counter < NET_DEV_COUNTERS; counter++)
+        {
+            if (interface_metrics[counter] != NULL)
+            {
+                prom_metric_sample_remove((prom_metric_t*)interface_metrics[counter], (const char*[]){removal->name});
+            }
+        }
+#endif
+    }
+    interface_removal_count = kept;
+    pthread_mutex_unlock(&removal_lock);
+}
+
+/**
+ * @brief Applies a group's newest batch to its gauges. Called by the scrape renderer with scrape_lock held.
+ *
+ * A stale group has its unlabeled series set to NaN instead; once it recovers, its front batch is applied again.
+ */
+static void expose_group(CollectorGroupId id)
+{
+    GroupBuffer* buffer = group_buffers[id];
+    bool reapply = false;
+    if (atomic_load_explicit(&buffer->exchange, memory_order_relaxed) & SLOT_FRESH)
+    {
+        unsigned int previous = atomic_exchange_explicit(&buffer->exchange, buffer->front, memory_order_acq_rel);
+        buffer->front = previous & SLOT_INDEX_MASK;
+        reapply = true;
+    }
+
+    bool stale = atomic_load_explicit(&group_stale[id], memory_order_acquire);
+    if (stale)
+    {
+        for (MetricInfo* info = all_metrics; info->name != NULL; info++)
+        {
+            if (info->group == id && info->label_count == 0 && *(info->metric) != NULL)
+            {
+                prom_gauge_set(*(info->metric), NAN, NULL);
+            }
+        }
+    }
+    else if (reapply || buffer->front_stale)
+    {
+        const PublishBatch* batch = &buffer->batches[buffer->front];
+        if (id == GROUP_NETWORK)
+        {
+            remove_interface_series(batch->generation);
+        }
+        for (size_t i = 0; i < batch->count; i++)
+        {
+            const StagedValue* staged = &batch->values[i];
+            const char* labels[STAGED_MAX_LABELS] = {staged->labels[0], staged->labels[1]};
+            prom_gauge_set(staged->metric, staged->value, staged->label_count > 0 ? labels : NULL);
+        }
+        if (batch->generation > exposed_generation)
+        {
+            exposed_generation = batch->generation;
+        }
+    }
+    buffer->front_stale = stale;
+}
+
+/**
+ * @brief Retrieves the current CLOCK_MONOTONIC time in milliseconds.
+ */
+static unsigned long long monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000ULL + (unsigned long long)now.tv_nsec / 1000000ULL;
+}
+
+/**
+ * @brief Publishes whether a collector group's last run succeeded.
+ *
+ * Failures are counted rather than logged; only the transitions between up and down are logged, so a sensor path
+ * that does not exist on this host costs one log line instead of one per run.
+ */
+static void set_collector_up(const CollectorGroup* group, bool up)
+{
+    const char* labels[] = {group->name};
+    size_t id = (size_t)(group - all_groups);
+
+    prom_gauge_set(collector_up_metric, up ? 1 : 0, labels);
+    if (!up)
+    {
+        prom_counter_inc(collector_errors_metric, labels);
+    }
+    if (up == collector_down[id])
+    {
+        if (up)
+        {
+            LOG_MESSAGE("Collector '%s' recovered\n", group->name);
+        }
+        else
+        {
+            LOG_MESSAGE("Collector '%s' failing, backing off\n", group->name);
+        }
+        collector_down[id] = !up;
+    }
+}
+
+void record_collector_run(const CollectorGroup* group, double duration_seconds, bool late, bool succeeded)
+{
+    const char* labels[] = {group->name};
+    prom_gauge_set(collector_duration_metric, duration_seconds, labels);
+    prom_gauge_set(collector_stale_metric, 0, labels);
+    atomic_store_explicit(&group_stale[group - all_groups], false, memory_order_release);
+    atomic_store_explicit(&last_run_ms[group - all_groups], monotonic_ms(), memory_order_relaxed);
+    if (late)
+    {
+        prom_counter_inc(collector_late_runs_metric, labels);
+    }
+    set_collector_up(group, succeeded);
+}
+
+void record_collector_timeout(const CollectorGroup* group)
+{
+    const char* labels[] = {group->name};
+    prom_counter_inc(collector_timeouts_metric, labels);
+    prom_gauge_set(collector_stale_metric, 1, labels);
+    set_collector_up(group, false);
+    atomic_store_explicit(&group_stale[group - all_groups], true, memory_order_release);
+    atomic_store_explicit(&last_run_ms[group - all_groups], monotonic_ms(), memory_order_relaxed);
+}
+
+void set_adaptive_threshold(double threshold)
+{
+    adaptive_threshold = threshold;
+}
+
+/**
+ * @brief Retrieves the interval of a group before the CPU budget throttle: the adaptive one, or the configured one.
+ */
+static unsigned int base_interval(const CollectorGroup* group)
+{
+    unsigned int interval = atomic_load_explicit(&effective_interval_ms[group - all_groups], memory_order_relaxed);
+    return interval > 0 ? interval : group->interval_ms;
+}
+
+unsigned int get_group_interval(const CollectorGroup* group)
+{
+    unsigned int shift = atomic_load_explicit(&throttle_shift[group - all_groups], memory_order_relaxed);
+    unsigned long long interval = (unsigned long long)base_interval(group) << shift;
+    return interval < UINT_MAX ? (unsigned int)interval : UINT_MAX;
+}
+
+void set_cpu_budget(double budget)
+{
+    cpu_budget = budget;
+    prom_gauge_set(cpu_budget_metric, budget, NULL);
+    for (size_t id = 0; id < GROUP_COUNT; id++)
+    {
+        if (all_groups[id].enabled)
+        {
+            prom_gauge_set(throttle_factor_metric, 1, (const char*[]){all_groups[id].name});
+        }
+    }
+}
+
+/**
+ * @brief Retrieves the value of a CPU-time clock in nanoseconds.
+ */
+static unsigned long long cpu_clock_ns(clockid_t clock)
+{
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+}
+
+/**
+ * @brief Changes the throttle of a group by one step and exports the decision.
+ */
+static void throttle_group(size_t id, bool stretch, double usage)
+{
+    unsigned int shift = atomic_load_explicit(&throttle_shift[id], memory_order_relaxed) + (stretch ? 1 : -1);
+    atomic_store_explicit(&throttle_shift[id], shift, memory_order_relaxed);
+    prom_gauge_set(throttle_factor_metric, (double)(1U << shift), (const char*[]){all_groups[id].name});
+    prom_counter_inc(throttle_decisions_metric, (const char*[]){all_groups[id].name, stretch ? "stretch" : "relax"});
+    LOG_MESSAGE("CPU use at %.2f%% of a core, %s collector '%s' to %ux its interval\n", usage * 100,
+                stretch ? "stretching" : "relaxing", all_groups[id].name, 1U << shift);
+}
+
+void govern_cpu_budget(void)
+{
+    if (cpu_budget <= 0)
+    {
+        return;
+    }
+
+    // A window spans at least one run of every group, or a stretched group would look free in the windows it skips
+    unsigned long long window_ms = GOVERNOR_WINDOW_MS;
+    for (size_t id = 0; id < GROUP_COUNT; id++)
+    {
+        if (all_groups[id].enabled && get_group_interval(&all_groups[id]) > window_ms)
+        {
+            window_ms = get_group_interval(&all_groups[id]);
+        }
+    }
+    unsigned long long now_ms = monotonic_ms();
+    if (governor_window_ms != 0 && now_ms - governor_window_ms < window_ms)
+    {
+        return;
+    }
+
+    unsigned long long process_ns = cpu_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    unsigned long long spent_ns[GROUP_COUNT];
+    for (size_t id = 0; id < GROUP_COUNT; id++)
+    {
+        unsigned long long total_ns = atomic_load_explicit(&group_cpu_ns[id], memory_order_relaxed);
+        spent_ns[id] = total_ns - governor_group_ns[id];
+        governor_group_ns[id] = total_ns;
+    }
+    if (governor_window_ms == 0)
+    {
+        governor_window_ms = now_ms;
+        governor_process_ns = process_ns;
+        return; // First call: only open the window
+    }
+
+    double usage = (double)(process_ns - governor_process_ns) / ((double)(now_ms - governor_window_ms) * 1e6);
+    governor_window_ms = now_ms;
+    governor_process_ns = process_ns;
+    prom_gauge_set(cpu_usage_ratio_metric, usage, NULL);
+
+    // Stretch the group that used the most CPU in the window and can still be stretched
+    bool stretch = usage > cpu_budget;
+    size_t chosen = GROUP_COUNT;
+    double added = 0;
+    for (size_t id = 0; id < GROUP_COUNT && stretch; id++)
+    {
+        unsigned int shift = atomic_load_explicit(&throttle_shift[id], memory_order_relaxed);
+        if (all_groups[id].enabled && shift < GOVERNOR_MAX_SHIFT && spent_ns[id] > 0 &&
+            (chosen == GROUP_COUNT || spent_ns[id] > spent_ns[chosen]))
+        {
+            chosen = id;
+        }
+    }
+
+    // Relax the throttled group whose halved interval adds the least CPU, judged from its last run rather than the
+    // window, which a heavily stretched group may not have run in. Its current rate is counted twice so a group
+    // that did run in the window does not push the process straight back over the budget.
+    for (size_t id = 0; id < GROUP_COUNT && !stretch && usage < cpu_budget * GOVERNOR_RELAX_RATIO; id++)
+    {
+        if (!all_groups[id].enabled || atomic_load_explicit(&throttle_shift[id], memory_order_relaxed) == 0)
+        {
+            continue;
+        }
+        double rate = (double)atomic_load_explicit(&last_run_cpu_ns[id], memory_order_relaxed) /
+                      ((double)get_group_interval(&all_groups[id]) * 1e6);
+        if (usage + 2 * rate < cpu_budget && (chosen == GROUP_COUNT || rate < added))
+        {
+            chosen = id;
+            added = rate;
+        }
+    }
+
+    if (chosen != GROUP_COUNT)
+    {
+        throttle_group(chosen, stretch, usage);
+    }
+}
+
+/**
+ * @brief Creates and registers one aggregate family of a series.
+ */
+static prom_gauge_t* new_aggregate_family(char* name, const char* base, const char* suffix, const char* description)
+{
+    snprintf(name, AGGREGATE_NAME_SIZE, "%s_%s", base, suffix);
+    prom_gauge_t* gauge = prom_gauge_new(name, description, 0, NULL);
+    prom_collector_registry_must_register_metric((prom_metric_t*)gauge);
+    return gauge;
+}
+
+int set_aggregated_groups(const char* spec)
+{
+    char* spec_copy = strdup(spec);
+    if (spec_copy == NULL)
+    {
+        return RETURN_ERROR;
+    }
+
+    int result = 0;
+    char* saveptr = NULL;
+    for (char* entry = strtok_r(spec_copy, ",", &saveptr); entry != NULL; entry = strtok_r(NULL, ",", &saveptr))
+    {
+        size_t id = 0;
+        while (id < GROUP_COUNT && strcmp(all_groups[id].name, entry) != 0)
+        {
+            id++;
+        }
+        if (id == GROUP_COUNT)
+        {
+            fprintf(stderr, "Error: Unknown collector group '%s'\n", entry);
+            result = RETURN_ERROR;
+            continue;
+        }
+        if (group_aggregated[id])
+        {
+            continue; // Listed twice
+        }
+
+        for (MetricInfo* info = all_metrics; info->name != NULL; info++)
+        {
+            if (info->group != id || info->label_count != 0 || *(info->metric) == NULL)
+            {
+                continue;
+            }
+            if (aggregate_count == AGGREGATE_MAX_SERIES)
+            {
+                fprintf(stderr, "Error: More than %d aggregated series\n", AGGREGATE_MAX_SERIES);
+                free(spec_copy);
+                return RETURN_ERROR;
+            }
+
+            AggregateSeries* series = calloc(1, sizeof(AggregateSeries));
+            if (series == NULL)
+            {
+                free(spec_copy);
+                return RETURN_ERROR;
+            }
+            series->group = (CollectorGroupId)id;
+            series->source = *(info->metric);
+            series->min_metric =
+                new_aggregate_family(series->names[0], info->name, "min", "Minimum since the previous scrape");
+            series->max_metric =
+                new_aggregate_family(series->names[1], info->name, "max", "Maximum since the previous scrape");
+            series->avg_metric =
+                new_aggregate_family(series->names[2], info->name, "avg", "Average since the previous scrape");
+            for (size_t q = 0; q < SAMPLE_QUANTILE_COUNT; q++)
+            {
+                // The client library reserves the quantile label for summaries, so each quantile is its own family
+                char suffix[16];
+                snprintf(suffix, sizeof(suffix), "p%g", sample_quantiles[q] * 100);
+                series->quantile_metrics[q] = new_aggregate_family(series->names[3 + q], info->name, suffix,
+                                                                   "Quantile since the previous scrape");
+            }
+            aggregate_series[aggregate_count++] = series;
+            group_aggregated[id] = true;
+        }
+    }
+
+    free(spec_copy);
+    return result;
+}
+
+void set_lazy_collection(unsigned int max_age_ms)
+{
+    lazy_max_age_ms = max_age_ms;
+}
+
+void record_tick_lateness(double lateness_seconds)
+{
+    prom_histogram_observe(tick_lateness_metric, lateness_seconds, NULL);
+}
+
+void record_tick_overrun(const CollectorGroup* group, unsigned long long missed)
+{
+    prom_counter_add(tick_overruns_metric, (double)missed, (const char*[]){group->name});
+}
+
+void record_collector_skip(const CollectorGroup* group)
+{
+    prom_counter_inc(collector_skipped_runs_metric, (const char*[]){group->name});
+}
+
+size_t get_enabled_groups(CollectorGroup* groups[], size_t max_groups)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < GROUP_COUNT && count < max_groups; i++)
+    {
+        if (all_groups[i].enabled)
+        {
+            groups[count++] = &all_groups[i];
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Stretches or tightens the interval of a group with adaptive bounds from the run about to be published.
+ *
+ * Volatility is the largest relative change of the group's first ADAPTIVE_TRACKED_VALUES unlabeled values since the
+ * previous run; magnitudes below 1 count as 1 so values hovering around zero do not look volatile.
+ */
+static void adapt_interval(const CollectorGroup* group, GroupBuffer* buffer)
+{
+    if (adaptive_threshold <= 0 || group->max_interval_ms == 0)
+    {
+        return;
+    }
+
+    const PublishBatch* batch = &buffer->batches[buffer->back];
+    double volatility = 0;
+    size_t tracked = 0;
+    for (size_t i = 0; i < batch->count && tracked < ADAPTIVE_TRACKED_VALUES; i++)
+    {
+        double value = batch->values[i].value;
+        if (batch->values[i].label_count > 0 || !isfinite(value))
+        {
+            continue;
+        }
+        if (tracked < buffer->previous_count)
+        {
+            double previous = buffer->previous[tracked];
+            double change = fabs(value - previous) / fmax(fmax(fabs(previous), fabs(value)), 1.0);
+            volatility = fmax(volatility, change);
+        }
+        buffer->previous[tracked++] = value;
+    }
+    bool first_run = buffer->previous_count == 0;
+    buffer->previous_count = tracked;
+    if (first_run || tracked == 0)
+    {
+        return;
+    }
+
+    unsigned int interval = base_interval(group);
+    unsigned int next = group->min_interval_ms;
+    if (volatility < adaptive_threshold)
+    {
+        unsigned long long stretched = (unsigned long long)interval + interval / 4 + 1;
+        next = stretched < group->max_interval_ms ? (unsigned int)stretched : group->max_interval_ms;
+    }
+    atomic_store_explicit(&effective_interval_ms[group - all_groups], next, memory_order_relaxed);
+}
+
+/**
+ * @brief Pushes the aggregated values of the run about to be published into their sample rings.
+ */
+static void record_samples(const CollectorGroup* group, const GroupBuffer* buffer)
+{
+    const PublishBatch* batch = &buffer->batches[buffer->back];
+    CollectorGroupId id = (CollectorGroupId)(group - all_groups);
+    for (size_t s = 0; s < aggregate_count; s++)
+    {
+        AggregateSeries* series = aggregate_series[s];
+        if (series->group != id)
+        {
+            continue;
+        }
+        for (size_t i = 0; i < batch->count; i++)
+        {
+            if (batch->values[i].label_count == 0 && batch->values[i].metric == series->source)
+            {
+                sample_ring_push(&series->ring, batch->values[i].value);
+                break;
+            }
+        }
+    }
+}
+
+int run_collector_group(const CollectorGroup* group)
+{
+    GroupBuffer* buffer = group_buffers[group - all_groups];
+    capture_begin_group(group->name, metrics_current_tick());
+    current_buffer = buffer;
+    unsigned long long start_ns = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    int status = group->update_function();
+    unsigned long long cpu_ns = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID) - start_ns;
+    current_buffer = NULL;
+    capture_end_group();
+    atomic_fetch_add_explicit(&group_cpu_ns[group - all_groups], cpu_ns, memory_order_relaxed);
+    atomic_store_explicit(&last_run_cpu_ns[group - all_groups], cpu_ns, memory_order_relaxed);
+    prom_counter_add(collector_cpu_metric, (double)cpu_ns / 1e9, (const char*[]){group->name});
+    if (buffer != NULL)
+    {
+        if (status == 0)
+        {
+            adapt_interval(group, buffer);
+        }
+        if (group_aggregated[group - all_groups] && !worker_run_abandoned())
+        {
+            record_samples(group, buffer);
+        }
+        publish_batch(buffer);
+    }
+    return status;
+}
+
+unsigned long long replay_collection(void)
+{
+    unsigned long long ticks = 0;
+    while (capture_replay_next_tick())
+    {
+        metrics_begin_tick();
+        const char* name;
+        while ((name = capture_replay_next_group()) != NULL)
+        {
+            for (size_t i = 0; i < GROUP_COUNT; i++)
+            {
+                if (all_groups[i].enabled && strcmp(all_groups[i].name, name) == 0)
+                {
+                    run_collector_group(&all_groups[i]);
+                    break;
+                }
+            }
+        }
+        ticks++;
+    }
+    return ticks;
+}
+
+size_t get_background_groups(CollectorGroup* groups[], size_t max_groups)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < GROUP_COUNT && count < max_groups; i++)
+    {
+        if (all_groups[i].enabled && (lazy_max_age_ms == 0 || all_groups[i].keeps_history))
+        {
+            groups[count++] = &all_groups[i];
+        }
+    }
+    return count;
+}
 
-MetricInfo all_metrics[] = {
-    {"rx_bytes_total", "Total received bytes", &rx_bytes_metric, &update_network_traffic_metric},
-    {"tx_bytes_total", "Total transmitted bytes", &tx_bytes_metric, &update_network_traffic_metric},
-    {"rx_errors_total", "Total receive errors", &rx_errors_metric, &update_network_traffic_metric},
-    {"tx_errors_total", "Total transmit errors", &tx_errors_metric, &update_network_traffic_metric},
-    {"dropped_packets_total", "Total dropped packets", &dropped_packets_metric, &update_network_traffic_metric},
-    {"io_time_ms", "Time spent on I/O in milliseconds", &io_time_metric, &update_disk_stats_metrics},
-    {"writes_completed_total", "Total writes completed", &writes_completed_metric, &update_disk_stats_metrics},
-    {"reads_completed_total", "Total reads completed", &reads_completed_metric, &update_disk_stats_metrics},
-    {"total_memory_mb", "Total memory in MB", &total_memory_metric, &update_memory_metrics},
-    {"used_memory_mb", "Used memory in MB", &used_memory_metric, &update_memory_metrics},
-    {"available_memory_mb", "Available memory in MB", &available_memory_metric, &update_memory_metrics},
-    {"context_switches", "Context switches", &context_switches_metric, &update_context_switches_metric},
-    {"cpu_usage_percentage", "CPU usage in percentage", &cpu_usage_metric, &update_cpu_gauge},
-    {"memory_usage_percentage", "Memory usage in percentage", &memory_usage_metric, &update_memory_gauge},
-    {"disk_usage_percentage", "Disk usage in percentage", &disk_usage_metric, &update_disk_gauge},
-    {"running_processes_total", "Total running processes", &running_processes_metric, &update_running_processes_gauge},
-    {"cpu_temperature_celsius", "CPU temperature in Celsius", &cpu_temp_metric, &update_cpu_temperature},
-    {"battery_voltage_volts", "Battery voltage in volts", &battery_voltage_metric, &update_battery_voltage},
-    {"battery_current_amperes", "Battery current in amperes", &battery_current_metric, &update_battery_current},
-    {"cpu_frequency_megahertz", "CPU frequency in MHz", &cpu_frequency_metric, &update_cpu_frequency},
-    {"cpu_fan_speed_rpm", "CPU fan speed in RPM", &cpu_fan_speed_metric, &update_cpu_fan_speed},
-    {"gpu_fan_speed_rpm", "GPU fan speed in RPM", &gpu_fan_speed_metric, &update_gpu_fan_speed},
-    {"total_processes", "Total number of processes", &total_processes_metric, &update_process_states_gauge},
-    {"suspended_processes", "Suspended processes", &suspended_processes_metric, &update_process_states_gauge},
-    {"ready_processes", "Ready processes", &ready_processes_metric, &update_process_states_gauge},
-    {"blocked_processes", "Blocked processes", &blocked_processes_metric, &update_process_states_gauge},
-    {NULL, NULL, NULL} // Sentinel value to mark the end of the array
-};
 void update_gauge(prom_gauge_t* metric, double value)
 {
-    pthread_mutex_lock(&lock);
-    prom_gauge_set(metric, value, NULL);
-    pthread_mutex_unlock(&lock);
+    stage_value(metric, NULL, value);
 }
 
-void update_cpu_gauge(void)
+int update_cpu_gauge(void)
 {
     double usage = get_cpu_usage();
-    if (usage >= 0)
+    if (usage < 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    update_gauge(cpu_usage_metric, usage);
+    return 0;
+}
+
+int update_core_metrics(void)
+{
+    static const char* modes[] = {"user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal"};
+    static double seconds_per_jiffy = 0;
+    if (seconds_per_jiffy == 0)
+    {
+        long ticks = sysconf(_SC_CLK_TCK);
+        seconds_per_jiffy = 1.0 / (double)(ticks > 0 ? ticks : 100);
+    }
+
+    ssize_t count = get_core_times(&cpu_cores, &cpu_cores_capacity);
+    if (count < 0)
     {
-        update_gauge(cpu_usage_metric, usage);
+        return RETURN_ERROR;
     }
-    else
+
+    for (size_t i = 0; i < (size_t)count; i++)
     {
-        fprintf(stderr, "Error obtaining CPU usage\n");
+        const CoreTimes* core = &cpu_cores[i];
+        char cpu[16];
+        snprintf(cpu, sizeof(cpu), "%u", core->id);
+
+        if (cpu_seconds_metric != NULL)
+        {
+            const unsigned long long jiffies[] = {core->times.user,    core->times.nice, core->times.system,
+                                                  core->times.idle,    core->times.iowait, core->times.irq,
+                                                  core->times.softirq, core->times.steal};
+            for (size_t mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++)
+            {
+                stage_labeled_value(cpu_seconds_metric, (const char*[]){cpu, modes[mode]}, 2,
+                                    (double)jiffies[mode] * seconds_per_jiffy);
+            }
+        }
+
+        // Cores keep their position unless one goes offline or comes back; skip those until the next run
+        if (core_usage_metric != NULL && i < previous_core_count && previous_cores[i].id == core->id)
+        {
+            double usage = cpu_times_usage(&previous_cores[i].times, &core->times);
+            if (usage >= 0)
+            {
+                stage_value(core_usage_metric, cpu, usage);
+            }
+        }
     }
+
+    // The current counters become the previous ones by swapping the arrays, never by copying them
+    CoreTimes* cores = previous_cores;
+    size_t capacity = previous_cores_capacity;
+    previous_cores = cpu_cores;
+    previous_cores_capacity = cpu_cores_capacity;
+    previous_core_count = (size_t)count;
+    cpu_cores = cores;
+    cpu_cores_capacity = capacity;
+    return 0;
 }
 
-void update_memory_gauge(void)
+int update_cpu_windows(void)
 {
-    double usage = get_memory_usage();
-    if (usage >= 0)
+    static const char* labels[CPU_WINDOW_COUNT] = {"1s", "10s", "1m", "5m"};
+
+    double usage[CPU_WINDOW_COUNT];
+    if (get_cpu_window_usage(usage) != 0)
     {
-        update_gauge(memory_usage_metric, usage);
+        return RETURN_ERROR;
     }
-    else
+
+    for (size_t window = 0; window < CPU_WINDOW_COUNT; window++)
     {
-        fprintf(stderr, "Error obtaining memory usage\n");
+        if (usage[window] >= 0) // Nothing has elapsed yet on the first run
+        {
+            stage_value(window_usage_metric, labels[window], usage[window]);
+        }
     }
+    return 0;
 }
 
-void update_disk_gauge(void)
+int update_cpu_group(void)
 {
-    double usage = get_disk_usage();
-    if (usage >= 0)
+    int status = 0;
+    if (cpu_usage_metric != NULL && update_cpu_gauge() != 0)
+    {
+        status = RETURN_ERROR;
+    }
+    if ((cpu_seconds_metric != NULL || core_usage_metric != NULL) && update_core_metrics() != 0)
     {
-        update_gauge(disk_usage_metric, usage);
+        status = RETURN_ERROR;
     }
-    else
+    if (window_usage_metric != NULL && update_cpu_windows() != 0)
     {
-        fprintf(stderr, "Error obtaining disk usage\n");
+        status = RETURN_ERROR;
     }
+    return status;
 }
 
-void update_running_processes_gauge(void)
+int update_memory_gauge(void)
 {
-    FILE* fp = fopen(PROC_STAT_PATH, "r");
-    if (fp == NULL)
+    double usage = get_memory_usage();
+    if (usage < 0)
     {
-        perror("Error opening /proc/stat");
-        return;
+        return RETURN_ERROR;
+    }
+
+    update_gauge(memory_usage_metric, usage);
+    return 0;
+}
+
+int update_disk_gauge(void)
+{
+    double usage = get_disk_usage();
+    if (usage < 0)
+    {
+        return RETURN_ERROR;
     }
 
-    char buffer[BUFFER_SIZE];
-    unsigned long running_processes = 0;
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    update_gauge(disk_usage_metric, usage);
+    return 0;
+}
+
+int update_running_processes_gauge(void)
+{
+    long long running_processes = get_running_processes();
+    if (running_processes < 0)
     {
-        if (sscanf(buffer, "procs_running %lu", &running_processes) == 1)
-        {
-            break;
-        }
+        return RETURN_ERROR;
     }
-    fclose(fp);
 
     update_gauge(running_processes_metric, (double)running_processes);
+    return 0;
+}
+
+int update_proc_stat_counters(void)
+{
+    ProcStatSnapshot snapshot;
+    if (get_proc_stat_snapshot(&snapshot) != 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    update_gauge(interrupts_metric, (double)snapshot.interrupts);
+    update_gauge(forks_metric, (double)snapshot.processes);
+    update_gauge(blocked_tasks_metric, (double)snapshot.procs_blocked);
+    update_gauge(softirqs_metric, (double)snapshot.softirqs);
+    return 0;
 }
 
-void update_process_states_gauge(void)
+int update_process_states_gauge(void)
 {
     int total, suspended, ready, blocked;
-    get_process_states(&total, &suspended, &ready, &blocked);
+    if (get_process_states(&total, &suspended, &ready, &blocked) != 0)
+    {
+        return RETURN_ERROR;
+    }
 
-    pthread_mutex_lock(&lock);
-    prom_gauge_set(total_processes_metric, total, NULL);
-    prom_gauge_set(suspended_processes_metric, suspended, NULL);
-    prom_gauge_set(ready_processes_metric, ready, NULL);
-    prom_gauge_set(blocked_processes_metric, blocked, NULL);
-    pthread_mutex_unlock(&lock);
+    update_gauge(total_processes_metric, total);
+    update_gauge(suspended_processes_metric, suspended);
+    update_gauge(ready_processes_metric, ready);
+    update_gauge(blocked_processes_metric, blocked);
+    return 0;
 }
 
-void update_cpu_temperature(void)
+int update_cpu_temperature(void)
 {
     double cpu_temp = get_cpu_temperature();
-    if (cpu_temp >= 0)
+    if (cpu_temp < 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    update_gauge(cpu_temp_metric, cpu_temp);
+    return 0;
+}
+
+int update_battery_voltage(void)
+{
+    double voltage = get_battery_voltage();
+    if (voltage < 0)
     {
-        update_gauge(cpu_temp_metric, cpu_temp);
+        return RETURN_ERROR;
     }
-    else
+
+    update_gauge(battery_voltage_metric, voltage);
+    return 0;
+}
+
+int update_battery_current(void)
+{
+    double current = get_battery_current();
+    if (current < 0)
     {
-        fprintf(stderr, "Error getting CPU temperature\n");
+        return RETURN_ERROR;
     }
+
+    update_gauge(battery_current_metric, current);
+    return 0;
 }
 
-void update_battery_voltage(void)
+int update_cpu_frequency(void)
 {
-    double voltage = get_battery_voltage();
-    if (voltage >= 0)
+    double freq = get_cpu_frequency();
+    if (freq < 0)
     {
-        update_gauge(battery_voltage_metric, voltage);
+        return RETURN_ERROR;
     }
-    else
+
+    update_gauge(cpu_frequency_metric, freq);
+    return 0;
+}
+
+int update_cpu_fan_speed(void)
+{
+    double speed = get_cpu_fan_speed();
+    if (speed < 0)
     {
-        fprintf(stderr, "Error getting battery voltage\n");
+        return RETURN_ERROR;
     }
+
+    update_gauge(cpu_fan_speed_metric, speed);
+    return 0;
 }
 
-void update_battery_current(void)
+int update_gpu_fan_speed(void)
 {
-    double current = get_battery_current();
-    if (current >= 0)
+    double speed = get_gpu_fan_speed();
+    if (speed < 0)
     {
-        update_gauge(battery_current_metric, current);
+        return RETURN_ERROR;
     }
-    else
+
+    update_gauge(gpu_fan_speed_metric, speed);
+    return 0;
+}
+
+int update_memory_metrics(void)
+{
+    double total = get_total_memory();
+    double used = get_used_memory();
+    double available = get_available_memory();
+    if (total < 0 || used < 0 || available < 0)
     {
-        fprintf(stderr, "Error getting battery current\n");
+        return RETURN_ERROR;
     }
+
+    update_gauge(total_memory_metric, total);
+    update_gauge(used_memory_metric, used);
+    update_gauge(available_memory_metric, available);
+    return 0;
 }
 
-void update_cpu_frequency(void)
+int update_memory_group(void)
 {
-    double freq = get_cpu_frequency();
-    if (freq >= 0)
+    int status = 0;
+    if ((total_memory_metric != NULL || used_memory_metric != NULL || available_memory_metric != NULL) &&
+        update_memory_metrics() != 0)
+    {
+        status = RETURN_ERROR;
+    }
+    if (memory_usage_metric != NULL && update_memory_gauge() != 0)
     {
-        update_gauge(cpu_frequency_metric, freq);
+        status = RETURN_ERROR;
     }
-    else
+    if ((meminfo_kb_metric != NULL || meminfo_pages_metric != NULL) && update_meminfo_fields() != 0)
     {
-        fprintf(stderr, "Error getting CPU frequency\n");
+        status = RETURN_ERROR;
     }
+    return status;
 }
 
-void update_cpu_fan_speed(void)
+int update_proc_stat_group(void)
 {
-    double speed = get_cpu_fan_speed();
-    if (speed >= 0)
+    int status = 0;
+    if (context_switches_metric != NULL && update_context_switches_metric() != 0)
+    {
+        status = RETURN_ERROR;
+    }
+    if (running_processes_metric != NULL && update_running_processes_gauge() != 0)
     {
-        update_gauge(cpu_fan_speed_metric, speed);
+        status = RETURN_ERROR;
     }
-    else
+    if ((interrupts_metric != NULL || forks_metric != NULL || blocked_tasks_metric != NULL ||
+         softirqs_metric != NULL) &&
+        update_proc_stat_counters() != 0)
     {
-        fprintf(stderr, "Error getting CPU fan speed\n");
+        status = RETURN_ERROR;
     }
+    return status;
 }
 
-void update_gpu_fan_speed(void)
+int update_meminfo_fields(void)
 {
-    double speed = get_gpu_fan_speed();
-    if (speed >= 0)
+    MeminfoSnapshot snapshot;
+    if (get_meminfo_snapshot(&snapshot) != 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    for (size_t i = 0; i < snapshot.count; i++)
+    {
+        const MeminfoField* field = &snapshot.fields[i];
+        stage_value(field->in_kb ? meminfo_kb_metric : meminfo_pages_metric, field->name, (double)field->value);
+    }
+    return 0;
+}
+
+#ifdef HAVE_PROM_SAMPLE_REMOVE
+
+/**
+ * @brief Queues the series of a deleted or renamed interface for deletion. Called back by netlink_stats_poll().
+ */
+static void interface_removed(const char* name)
+{
+    size_t length = strlen(name);
+    if (length >= INTERFACE_NAME_SIZE || !interface_filter_match(name, length))
     {
-        update_gauge(gpu_fan_speed_metric, speed);
+        return; // Never exported
     }
-    else
+
+    pthread_mutex_lock(&removal_lock);
+    if (interface_removal_count == interface_removal_capacity)
+    {
+        size_t capacity = interface_removal_capacity > 0 ? interface_removal_capacity * 2 : INTERFACE_INITIAL_CAPACITY;
+        InterfaceRemoval* grown = realloc(interface_removals, capacity * sizeof(InterfaceRemoval));
+        if (grown == NULL)
+        {
+            pthread_mutex_unlock(&removal_lock);
+            return; // The series lingers, as it did before removals were tracked
+        }
+        interface_removals = grown;
+        interface_removal_capacity = capacity;
+    }
+    InterfaceRemoval* removal = &interface_removals[interface_removal_count++];
+    memcpy(removal->name, name, length + 1);
+    removal->generation = atomic_load_explicit(&publish_generation, memory_order_relaxed);
+    pthread_mutex_unlock(&removal_lock);
+}
+
+int watch_interfaces(void)
+{
+    for (size_t counter = 0; counter < NET_DEV_COUNTERS; counter++)
     {
-        fprintf(stderr, "Error getting GPU fan speed\n");
+        if (interface_metrics[counter] != NULL)
+        {
+            return netlink_stats_watch(interface_removed);
+        }
     }
+    return 0; // No per-interface series selected
 }
 
-void update_memory_metrics(void)
+#else
+
+int watch_interfaces(void)
 {
-    update_gauge(total_memory_metric, get_total_memory());
-    update_gauge(used_memory_metric, get_used_memory());
-    update_gauge(available_memory_metric, get_available_memory());
+    return -1; // This libprom cannot delete samples
 }
 
-void update_network_traffic_metric(void)
+#endif // HAVE_PROM_SAMPLE_REMOVE
+
+int update_network_traffic_metric(void)
 {
-    NetworkStats stats = get_network_traffic();
-    update_gauge(rx_bytes_metric, (double)stats.rx_bytes);
-    update_gauge(tx_bytes_metric, (double)stats.tx_bytes);
-    update_gauge(rx_errors_metric, (double)stats.rx_errors);
-    update_gauge(tx_errors_metric, (double)stats.tx_errors);
-    update_gauge(dropped_packets_metric, (double)stats.dropped_packets);
+    // Links deleted before this run are queued first, so this run's batch is the first one allowed to drop them
+    netlink_stats_poll();
+
+    ssize_t count = get_interface_stats(&interfaces, &interfaces_capacity);
+    if (count < 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    unsigned long long totals[NET_DEV_COUNTERS] = {0};
+    for (size_t i = 0; i < (size_t)count; i++)
+    {
+        const InterfaceStats* stats = &interfaces[i];
+        for (size_t counter = 0; counter < NET_DEV_COUNTERS; counter++)
+        {
+            totals[counter] += stats->counters[counter];
+            stage_value(interface_metrics[counter], stats->name, (double)stats->counters[counter]);
+        }
+    }
+
+    // The unlabeled gauges sum the selected interfaces
+    update_gauge(rx_bytes_metric, (double)totals[NET_RX_BYTES]);
+    update_gauge(tx_bytes_metric, (double)totals[NET_TX_BYTES]);
+    update_gauge(rx_errors_metric, (double)totals[NET_RX_ERRORS]);
+    update_gauge(tx_errors_metric, (double)totals[NET_TX_ERRORS]);
+    update_gauge(dropped_packets_metric, (double)totals[NET_RX_DROPPED]);
+    return 0;
 }
 
-void update_context_switches_metric(void)
+int update_context_switches_metric(void)
 {
-    update_gauge(context_switches_metric, get_context_switches());
+    long long context_switches = get_context_switches();
+    if (context_switches < 0)
+    {
+        return RETURN_ERROR;
+    }
+
+    update_gauge(context_switches_metric, (double)context_switches);
+    return 0;
 }
 
-void update_disk_stats_metrics(void)
+int update_disk_stats_metrics(void)
 {
     DiskStats stats = get_disk_stats();
-    if (stats.io_time >= 0)
+    if (stats.io_time == (unsigned long long)RETURN_ERROR)
+    {
+        return RETURN_ERROR;
+    }
+
+    update_gauge(io_time_metric, (double)stats.io_time);
+    update_gauge(writes_completed_metric, (double)stats.writes_completed);
+    update_gauge(reads_completed_metric, (double)stats.reads_completed);
+    return 0;
+}
+
+int update_reader_cache_metrics(void)
+{
+    update_gauge(syscalls_saved_metric, (double)reader_syscalls_saved());
+    return 0;
+}
+
+/**
+ * @brief Exposes the aggregates of the samples taken since the previous scrape. Called with scrape_lock held.
+ *
+ * A series without new samples keeps its previous aggregates.
+ */
+static void expose_aggregates(void)
+{
+    for (size_t s = 0; s < aggregate_count; s++)
+    {
+        AggregateSeries* series = aggregate_series[s];
+        SampleWindow window;
+        if (!sample_ring_drain(&series->ring, &window))
+        {
+            continue;
+        }
+
+        prom_gauge_set(series->min_metric, window.min, NULL);
+        prom_gauge_set(series->max_metric, window.max, NULL);
+        prom_gauge_set(series->avg_metric, window.avg, NULL);
+        for (size_t q = 0; q < SAMPLE_QUANTILE_COUNT; q++)
+        {
+            prom_gauge_set(series->quantile_metrics[q], window.quantiles[q], NULL);
+        }
+    }
+}
+
+/**
+ * @brief Collects, through the worker pool, every scrape-driven group whose last run is older than the max age.
+ *
+ * Only one scrape collects at a time; a scrape arriving meanwhile waits for that collection to end and then serves
+ * its results, which are at most as old as the max age.
+ */
+static void collect_stale_groups(void)
+{
+    pthread_mutex_lock(&collect_lock);
+    if (collecting)
+    {
+        unsigned long round = collect_round;
+        while (collecting && round == collect_round)
+        {
+            pthread_cond_wait(&collect_cond, &collect_lock);
+        }
+        pthread_mutex_unlock(&collect_lock);
+        return;
+    }
+    collecting = true;
+    pthread_mutex_unlock(&collect_lock);
+
+    unsigned long long now_ms = monotonic_ms();
+    CollectorGroup* due[GROUP_COUNT];
+    size_t num_due = 0;
+    for (size_t i = 0; i < GROUP_COUNT; i++)
+    {
+        unsigned long long last_ms = atomic_load_explicit(&last_run_ms[i], memory_order_relaxed);
+        if (all_groups[i].enabled && !all_groups[i].keeps_history &&
+            (last_ms == 0 || now_ms - last_ms >= lazy_max_age_ms))
+        {
+            due[num_due++] = &all_groups[i];
+        }
+    }
+
+    if (num_due > 0)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t)(lazy_max_age_ms / 1000U);
+        deadline.tv_nsec += (long)(lazy_max_age_ms % 1000U) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        metrics_begin_tick();
+        for (size_t i = 0; i < num_due; i++)
+        {
+            worker_pool_submit(due[i], &deadline);
+        }
+        for (size_t i = 0; i < num_due; i++)
+        {
+            worker_pool_wait(due[i]);
+        }
+    }
+
+    pthread_mutex_lock(&collect_lock);
+    collecting = false;
+    collect_round++;
+    pthread_cond_broadcast(&collect_cond);
+    pthread_mutex_unlock(&collect_lock);
+}
+
+/**
+ * @brief Renders the default registry from complete generations.
+ *
+ * In scrape-driven mode, groups older than the max age are collected first. Each group's newest published batch is
+ * then applied to its gauges right before rendering, with scrape_lock held, so every group is exposed from exactly
+ * one run and collectors never wait for a scrape. The newest generation included is appended as the
+ * metrics_generation gauge.
+ *
+ * @return The exposition text, to be freed by the caller, or NULL on error.
+ */
+static char* render_metrics(void)
+{
+    if (lazy_max_age_ms > 0)
+    {
+        collect_stale_groups();
+    }
+
+    pthread_mutex_lock(&scrape_lock);
+    for (size_t id = 0; id < GROUP_COUNT; id++)
+    {
+        if (group_buffers[id] != NULL)
+        {
+            expose_group((CollectorGroupId)id);
+            prom_gauge_set(collector_interval_metric, get_group_interval(&all_groups[id]) / 1000.0,
+                           (const char*[]){all_groups[id].name});
+        }
+    }
+    expose_aggregates();
+
+    unsigned long long log_dropped = logger_dropped();
+    unsigned long long log_suppressed = logger_suppressed();
+    prom_counter_add(log_dropped_metric, (double)(log_dropped - log_dropped_exposed), NULL);
+    prom_counter_add(log_suppressed_metric, (double)(log_suppressed - log_suppressed_exposed), NULL);
+    log_dropped_exposed = log_dropped;
+    log_suppressed_exposed = log_suppressed;
+    char* text = (char*)prom_collector_registry_bridge(PROM_COLLECTOR_REGISTRY_DEFAULT);
+    unsigned long generation = exposed_generation;
+    pthread_mutex_unlock(&scrape_lock);
+    if (text == NULL)
+    {
+        return NULL;
+    }
+
+    size_t length = strlen(text);
+    char* stamped = realloc(text, length + GENERATION_TRAILER_SIZE);
+    if (stamped == NULL)
+    {
+        return text;
+    }
+    snprintf(stamped + length, GENERATION_TRAILER_SIZE,
+             "# HELP metrics_generation Publish generation the exposed values belong to\n"
+             "# TYPE metrics_generation gauge\nmetrics_generation %lu\n",
+             generation);
+    return stamped;
+}
+
+/**
+ * @brief Queues a response with a static body.
+ */
+static enum MHD_Result respond_static(struct MHD_Connection* connection, unsigned int status, const char* body)
+{
+    struct MHD_Response* response =
+        MHD_create_response_from_buffer(strlen(body), (void*)body, MHD_RESPMEM_PERSISTENT);
+    enum MHD_Result result = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return result;
+}
+
+/**
+ * @brief HTTP request handler: serves /metrics from a complete generation and "OK" on /.
+ */
+static enum MHD_Result handle_request(void* cls, struct MHD_Connection* connection, const char* url,
+                                      const char* method, const char* version, const char* upload_data,
+                                      size_t* upload_data_size, void** con_cls)
+{
+    (void)cls;
+    (void)version;
+    (void)upload_data;
+    (void)upload_data_size;
+    (void)con_cls;
+
+    if (strcmp(method, "GET") != 0)
+    {
+        return respond_static(connection, MHD_HTTP_BAD_REQUEST, "Invalid HTTP Method\n");
+    }
+    if (strcmp(url, "/") == 0)
     {
-        update_gauge(io_time_metric, (double)stats.io_time);
-        update_gauge(writes_completed_metric, (double)stats.writes_completed);
-        update_gauge(reads_completed_metric, (double)stats.reads_completed);
+        return respond_static(connection, MHD_HTTP_OK, "OK\n");
     }
-    else
+    if (strcmp(url, "/metrics") != 0)
     {
-        fprintf(stderr, "Error obtaining disk stats\n");
+        return respond_static(connection, MHD_HTTP_BAD_REQUEST, "Bad Request\n");
     }
+
+    char* text = render_metrics();
+    if (text == NULL)
+    {
+        return respond_static(connection, MHD_HTTP_INTERNAL_SERVER_ERROR, "Error rendering metrics\n");
+    }
+    struct MHD_Response* response = MHD_create_response_from_buffer(strlen(text), text, MHD_RESPMEM_MUST_FREE);
+    enum MHD_Result result = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return result;
 }
 
 void* expose_metrics(const void* arg)
 {
     (void)arg;
 
-    promhttp_set_active_collector_registry(NULL);
-
-    struct MHD_Daemon* daemon = promhttp_start_daemon(MHD_USE_SELECT_INTERNALLY, 8000, NULL, NULL);
+    // Scrapes that collect block their connection, so give each connection its own thread to let others share it
+    unsigned int flags = MHD_USE_SELECT_INTERNALLY | (lazy_max_age_ms > 0 ? MHD_USE_THREAD_PER_CONNECTION : 0);
+    struct MHD_Daemon* daemon = MHD_start_daemon(flags, 8000, NULL, NULL, &handle_request, NULL, MHD_OPTION_END);
     if (daemon == NULL)
     {
         fprintf(stderr, "Error starting HTTP server\n");
@@ -296,34 +1679,111 @@ void* expose_metrics(const void* arg)
     return NULL;
 }
 
-void init_metrics(const char* selected_metrics[], size_t num_metrics)
+int init_metrics(const char* selected_metrics[], size_t num_metrics)
 {
-    if (pthread_mutex_init(&lock, NULL) != 0)
-    {
-        fprintf(stderr, "Error initializing mutex\n");
-    }
-
     if (prom_collector_registry_default_init() != 0)
     {
         fprintf(stderr, "Error initializing Prometheus registry\n");
     }
 
-    // Iterate over the selected metrics array and create/register the metrics
+    // Self metrics of the collector groups are always exposed
+    collector_late_runs_metric = prom_counter_new("collector_late_runs_total",
+                                                  "Collector runs that finished after their deadline", 1,
+                                                  collector_label_keys);
+    collector_skipped_runs_metric = prom_counter_new(
+        "collector_skipped_runs_total", "Collector runs skipped because the previous run was still in progress", 1,
+        collector_label_keys);
+    collector_duration_metric = prom_gauge_new("collector_duration_seconds", "Duration of the last collector run", 1,
+                                               collector_label_keys);
+    collector_timeouts_metric = prom_counter_new("collector_timeouts_total",
+                                                 "Collector runs abandoned after exceeding the collector timeout", 1,
+                                                 collector_label_keys);
+    collector_stale_metric = prom_gauge_new("collector_stale", "1 while a collector's series are stale after a timeout",
+                                            1, collector_label_keys);
+    collector_up_metric = prom_gauge_new("collector_up", "1 if the last collector run succeeded, 0 otherwise", 1,
+                                         collector_label_keys);
+    collector_errors_metric = prom_counter_new("collector_errors_total", "Collector runs that failed or timed out", 1,
+                                               collector_label_keys);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_late_runs_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_skipped_runs_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_duration_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_timeouts_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_stale_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_up_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_errors_metric);
+
+    // 100 us to ~100 ms; the wheel resolution is WHEEL_TICK_MS
+    tick_lateness_metric = prom_histogram_new("scheduler_tick_lateness_seconds",
+                                              "Time between a collection tick's deadline and the scheduler waking up",
+                                              prom_histogram_buckets_exponential(0.0001, 2, 11), 0, NULL);
+    tick_overruns_metric = prom_counter_new("scheduler_overruns_total",
+                                            "Collector runs skipped because the scheduler fell a whole interval behind",
+                                            1, collector_label_keys);
+    prom_collector_registry_must_register_metric((prom_metric_t*)tick_lateness_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)tick_overruns_metric);
+
+    collector_interval_metric = prom_gauge_new("collector_interval_seconds", "Interval a collector currently runs at",
+                                               1, collector_label_keys);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_interval_metric);
+
+    log_dropped_metric = prom_counter_new("log_messages_dropped_total",
+                                          "Log messages dropped because the logger queue was full", 0, NULL);
+    log_suppressed_metric = prom_counter_new("log_messages_suppressed_total",
+                                             "Log messages suppressed as repeats of the same call site", 0, NULL);
+    prom_collector_registry_must_register_metric((prom_metric_t*)log_dropped_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)log_suppressed_metric);
+
+    collector_cpu_metric = prom_counter_new("collector_cpu_seconds_total", "CPU time spent in a collector's runs", 1,
+                                            collector_label_keys);
+    cpu_usage_ratio_metric = prom_gauge_new("exporter_cpu_usage_ratio",
+                                            "Cores used by the exporter over the last CPU budget window", 0, NULL);
+    cpu_budget_metric = prom_gauge_new("exporter_cpu_budget_ratio", "Cores the exporter may use, 0 if unlimited", 0,
+                                       NULL);
+    throttle_factor_metric = prom_gauge_new("collector_throttle_factor",
+                                            "Multiplier applied to a collector's interval to meet the CPU budget", 1,
+                                            collector_label_keys);
+    throttle_decisions_metric = prom_counter_new("collector_throttle_decisions_total",
+                                                 "Intervals stretched or relaxed to meet the CPU budget", 2,
+                                                 throttle_label_keys);
+    prom_collector_registry_must_register_metric((prom_metric_t*)collector_cpu_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)cpu_usage_ratio_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)cpu_budget_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)throttle_factor_metric);
+    prom_collector_registry_must_register_metric((prom_metric_t*)throttle_decisions_metric);
+
+    // Create/register the selected metrics and enable the groups that publish them
     for (size_t i = 0; i < num_metrics; i++)
     {
-        const char* metric_name = selected_metrics[i];
+        MetricInfo* info = find_metric(selected_metrics[i]);
+        if (info == NULL)
+        {
+            fprintf(stderr, "Error: Unknown metric '%s'\n", selected_metrics[i]);
+            return RETURN_ERROR;
+        }
+        if (*(info->metric) != NULL)
+        {
+            continue; // Selected twice
+        }
 
-        // Find the metric in the all_metrics array
-        for (MetricInfo* info = all_metrics; info->name != NULL; info++)
+        if (group_buffers[info->group] == NULL)
         {
-            if (strcmp(metric_name, info->name) == 0)
+            group_buffers[info->group] = calloc(1, sizeof(GroupBuffer));
+            if (group_buffers[info->group] == NULL)
             {
-                *(info->metric) = prom_gauge_new(info->name, info->description, 0, NULL);
-                prom_collector_registry_must_register_metric((prom_metric_t*)*(info->metric));
-                break;
+                fprintf(stderr, "Error allocating the batches of group '%s'\n", all_groups[info->group].name);
+                return RETURN_ERROR;
             }
+            group_buffers[info->group]->back = 0;
+            atomic_init(&group_buffers[info->group]->exchange, 1);
+            group_buffers[info->group]->front = 2;
         }
+
+        *(info->metric) = prom_gauge_new(info->name, info->description, info->label_count, info->label_keys);
+        prom_collector_registry_must_register_metric((prom_metric_t*)*(info->metric));
+        all_groups[info->group].enabled = true;
     }
+
+    return 0;
 }
 
 void show_available_metrics(void)
@@ -345,5 +1805,24 @@ void show_available_metrics(void)
 
 void destroy_mutex(void)
 {
-    pthread_mutex_destroy(&lock);
+    pthread_mutex_destroy(&scrape_lock);
+    for (size_t id = 0; id < GROUP_COUNT; id++)
+    {
+        for (size_t i = 0; group_buffers[id] != NULL && i < 3; i++)
+        {
+            free(group_buffers[id]->batches[i].values);
+        }
+        free(group_buffers[id]);
+        group_buffers[id] = NULL;
+    }
+    free(interfaces);
+    interfaces = NULL;
+    interfaces_capacity = 0;
+    free(interface_removals);
+    interface_removals = NULL;
+    interface_removal_count = interface_removal_capacity = 0;
+    free(cpu_cores);
+    free(previous_cores);
+    cpu_cores = previous_cores = NULL;
+    cpu_cores_capacity = previous_cores_capacity = previous_core_count = 0;
 }
\ No newline at end of file
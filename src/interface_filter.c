@@ -0,0 +1,172 @@
+/**
+ * @file interface_filter.c
+ * @brief Include/exclude patterns over network interface names, compiled once into plain comparisons.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#define _GNU_SOURCE // memmem()
+
+#include "interface_filter.h"
+#include <fnmatch.h>
+#include <string.h>
+
+/**
+ * @brief Enumeration of the comparisons a pattern compiles to.
+ */
+typedef enum
+{
+    PATTERN_EXACT,    /**< No wildcard: the whole name. */
+    PATTERN_PREFIX,   /**< "text*": the start of the name. */
+    PATTERN_SUFFIX,   /**< "*text": the end of the name. */
+    PATTERN_CONTAINS, /**< "*text*": anywhere in the name. */
+    PATTERN_GLOB      /**< Anything else, matched with fnmatch(). */
+} PatternKind;
+
+/**
+ * @brief Structure to hold a compiled pattern.
+ */
+typedef struct
+{
+    PatternKind kind;                  /**< How text is compared. */
+    bool exclude;                      /**< Whether a match deselects the interface. */
+    size_t length;                     /**< Length of text. */
+    char text[INTERFACE_PATTERN_SIZE]; /**< Literal part of the pattern, or the whole glob. */
+} InterfacePattern;
+
+static InterfacePattern patterns[INTERFACE_MAX_PATTERNS]; /**< Compiled patterns, includes and excludes mixed. */
+static size_t pattern_count = 0;                          /**< Number of valid entries in patterns. */
+static bool has_includes = false;                         /**< Whether any include pattern is set. */
+
+/**
+ * @brief Compiles one pattern.
+ *
+ * @return 0 on success, or -1 if the pattern is too long.
+ */
+static int compile_pattern(const char* text, size_t length, bool exclude, InterfacePattern* pattern)
+{
+    if (length >= sizeof(pattern->text))
+    {
+        return -1;
+    }
+
+    bool leading = length > 0 && text[0] == '*';
+    bool trailing = length > (leading ? 1 : 0) && text[length - 1] == '*';
+    const char* literal = text + (leading ? 1 : 0);
+    size_t literal_length = length - (leading ? 1 : 0) - (trailing ? 1 : 0);
+
+    pattern->exclude = exclude;
+    if (memchr(literal, '*', literal_length) != NULL || memchr(literal, '?', literal_length) != NULL ||
+        memchr(literal, '[', literal_length) != NULL || memchr(literal, '\\', literal_length) != NULL)
+    {
+        pattern->kind = PATTERN_GLOB;
+        literal = text;
+        literal_length = length;
+    }
+    else if (leading)
+    {
+        pattern->kind = trailing ? PATTERN_CONTAINS : PATTERN_SUFFIX;
+    }
+    else
+    {
+        pattern->kind = trailing ? PATTERN_PREFIX : PATTERN_EXACT;
+    }
+    memcpy(pattern->text, literal, literal_length);
+    pattern->text[literal_length] = '\0';
+    pattern->length = literal_length;
+    return 0;
+}
+
+/**
+ * @brief Compiles a comma-separated list of patterns, appending them to compiled.
+ *
+ * @return 0 on success, or -1 if the list does not fit.
+ */
+static int compile_list(const char* list, bool exclude, InterfacePattern compiled[], size_t* count)
+{
+    while (list != NULL && *list != '\0')
+    {
+        const char* end = strchr(list, ',');
+        size_t length = end != NULL ? (size_t)(end - list) : strlen(list);
+        if (length > 0)
+        {
+            if (*count == INTERFACE_MAX_PATTERNS || compile_pattern(list, length, exclude, &compiled[*count]) != 0)
+            {
+                return -1;
+            }
+            (*count)++;
+        }
+        list = end != NULL ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks a name against one compiled pattern.
+ */
+static bool pattern_match(const InterfacePattern* pattern, const char* name, size_t length)
+{
+    if (pattern->kind == PATTERN_EXACT)
+    {
+        return length == pattern->length && memcmp(name, pattern->text, length) == 0;
+    }
+    if (pattern->kind == PATTERN_PREFIX)
+    {
+        return length >= pattern->length && memcmp(name, pattern->text, pattern->length) == 0;
+    }
+    if (pattern->kind == PATTERN_SUFFIX)
+    {
+        return length >= pattern->length &&
+               memcmp(name + length - pattern->length, pattern->text, pattern->length) == 0;
+    }
+    if (pattern->kind == PATTERN_CONTAINS)
+    {
+        return memmem(name, length, pattern->text, pattern->length) != NULL;
+    }
+
+    char terminated[INTERFACE_PATTERN_SIZE];
+    if (length >= sizeof(terminated))
+    {
+        return false;
+    }
+    memcpy(terminated, name, length);
+    terminated[length] = '\0';
+    return fnmatch(pattern->text, terminated, 0) == 0;
+}
+
+int interface_filter_set(const char* include, const char* exclude)
+{
+    InterfacePattern compiled[INTERFACE_MAX_PATTERNS];
+    size_t count = 0;
+    if (compile_list(include, false, compiled, &count) != 0)
+    {
+        return -1;
+    }
+    size_t includes = count;
+    if (compile_list(exclude, true, compiled, &count) != 0)
+    {
+        return -1;
+    }
+
+    memcpy(patterns, compiled, count * sizeof(InterfacePattern));
+    pattern_count = count;
+    has_includes = includes > 0;
+    return 0;
+}
+
+bool interface_filter_match(const char* name, size_t length)
+{
+    bool included = !has_includes;
+    for (size_t i = 0; i < pattern_count; i++)
+    {
+        if ((patterns[i].exclude || !included) && pattern_match(&patterns[i], name, length))
+        {
+            if (patterns[i].exclude)
+            {
+                return false;
+            }
+            included = true;
+        }
+    }
+    return included;
+}
@@ -0,0 +1,236 @@
+/**
+ * @file logger.c
+ * @brief Asynchronous, rate-limited logger: a bounded lock-free ring drained to stderr by a background thread.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "logger.h"
+#include "proc_parse.h"
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Structure to hold one slot of the message ring.
+ *
+ * The sequence number tells producers and the consumer whose turn the slot is: it equals the enqueue position when
+ * the slot is free for that position, and the position plus one once the message in it is ready to be written.
+ */
+typedef struct
+{
+    atomic_size_t sequence;         /**< Turn of the slot, see above. */
+    char text[LOGGER_MESSAGE_SIZE]; /**< The formatted message. */
+} LogSlot;
+
+static LogSlot ring[LOGGER_RING_SIZE]; /**< Queued messages. */
+static atomic_size_t enqueue_position; /**< Next position claimed by a producer. */
+static size_t dequeue_position;        /**< Next position written out, owned by the logger thread. */
+static atomic_ullong dropped;          /**< Messages dropped because the ring was full. */
+static atomic_ullong suppressed;       /**< Messages suppressed as repeats. */
+static atomic_bool running = false;    /**< Whether the logger thread is draining the ring. */
+static atomic_bool stopping = false;   /**< Set to make the logger thread exit once the ring is empty. */
+static sem_t pending;                  /**< Posted once per queued message, and on stop. */
+static pthread_t logger_thread;        /**< The thread writing messages out. */
+
+/**
+ * @brief Retrieves the current CLOCK_MONOTONIC time in milliseconds.
+ */
+static unsigned long long monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000ULL + (unsigned long long)now.tv_nsec / 1000000ULL;
+}
+
+/**
+ * @brief Writes out every message that is ready. Called by the logger thread only.
+ */
+static void drain_ring(void)
+{
+    while (true)
+    {
+        LogSlot* slot = &ring[dequeue_position & (LOGGER_RING_SIZE - 1)];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != dequeue_position + 1)
+        {
+            break;
+        }
+        fputs(slot->text, stderr);
+        atomic_store_explicit(&slot->sequence, dequeue_position + LOGGER_RING_SIZE, memory_order_release);
+        dequeue_position++;
+    }
+    fflush(stderr);
+}
+
+/**
+ * @brief Logger thread: writes messages out as they are queued until the logger stops.
+ */
+static void* logger_main(void* arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&stopping))
+    {
+        sem_wait(&pending);
+        drain_ring();
+    }
+    drain_ring();
+    return NULL;
+}
+
+/**
+ * @brief Checks a message against the call site's recent ones and records it if it is to be emitted.
+ *
+ * @return true if the message repeats one emitted within the window and must be suppressed.
+ */
+static bool is_repeat(LogSite* site, unsigned int hash, unsigned long long now_ms)
+{
+    size_t oldest = 0;
+    unsigned long long oldest_ms = ULLONG_MAX;
+    for (size_t i = 0; i < LOGGER_SITE_MEMORY; i++)
+    {
+        unsigned long long emitted_ms = atomic_load_explicit(&site->emitted_ms[i], memory_order_relaxed);
+        if (emitted_ms != 0 && atomic_load_explicit(&site->hashes[i], memory_order_relaxed) == hash)
+        {
+            if (now_ms - emitted_ms < LOGGER_DEDUP_WINDOW_MS)
+            {
+                return true;
+            }
+            oldest = i; // Reuse the entry of the same message once its window has passed
+            break;
+        }
+        if (emitted_ms < oldest_ms)
+        {
+            oldest = i;
+            oldest_ms = emitted_ms;
+        }
+    }
+
+    // Two threads racing on the same site may both emit; that is the only cost of not locking here
+    atomic_store_explicit(&site->hashes[oldest], hash, memory_order_relaxed);
+    atomic_store_explicit(&site->emitted_ms[oldest], now_ms, memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Claims a slot and copies a message into it.
+ *
+ * @return false if the ring is full.
+ */
+static bool enqueue(const char* text)
+{
+    size_t position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+    LogSlot* slot;
+    while (true)
+    {
+        slot = &ring[position & (LOGGER_RING_SIZE - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false; // The logger thread has not written this slot out yet
+        }
+        else
+        {
+            position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+        }
+    }
+
+    snprintf(slot->text, sizeof(slot->text), "%s", text);
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    return true;
+}
+
+int logger_start(void)
+{
+    for (size_t i = 0; i < LOGGER_RING_SIZE; i++)
+    {
+        atomic_init(&ring[i].sequence, i);
+    }
+    if (sem_init(&pending, 0, 0) != 0)
+    {
+        return -1;
+    }
+    atomic_store(&stopping, false);
+    if (pthread_create(&logger_thread, NULL, logger_main, NULL) != 0)
+    {
+        sem_destroy(&pending);
+        return -1;
+    }
+    atomic_store(&running, true);
+    return 0;
+}
+
+void logger_stop(void)
+{
+    if (!atomic_exchange(&running, false))
+    {
+        return;
+    }
+    atomic_store(&stopping, true);
+    sem_post(&pending);
+    pthread_join(logger_thread, NULL);
+    sem_destroy(&pending);
+}
+
+void logger_write(LogSite* site, const char* format, ...)
+{
+    char text[LOGGER_MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0)
+    {
+        return;
+    }
+
+    size_t used = (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1;
+    if (is_repeat(site, parse_hash(text, used), monotonic_ms()))
+    {
+        atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&suppressed, 1, memory_order_relaxed);
+        return;
+    }
+
+    unsigned long repeats = atomic_exchange_explicit(&site->suppressed, 0, memory_order_relaxed);
+    if (repeats > 0 && used > 0 && text[used - 1] == '\n')
+    {
+        snprintf(text + used - 1, sizeof(text) - (used - 1), " (%lu repeats suppressed)\n", repeats);
+    }
+
+    if (!atomic_load(&running))
+    {
+        fputs(text, stderr);
+        return;
+    }
+    if (!enqueue(text))
+    {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    sem_post(&pending);
+}
+
+unsigned long long logger_dropped(void)
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+unsigned long long logger_suppressed(void)
+{
+    return atomic_load_explicit(&suppressed, memory_order_relaxed);
+}
@@ -7,15 +7,41 @@
  */
 
 #include "expose_metrics.h"
+#include "capture.h"
+#include "interface_filter.h"
+#include "logger.h"
 #include "metrics.h"
+#include "batch_reader.h"
+#include "netlink_stats.h"
+#include "reader_cache.h"
+#include "scheduler.h"
+#include "worker_pool.h"
 #define FIFO_PATH "/tmp/monitor_fifo"
 #define BUFFER_SIZE 256
 #define MAX_METRICS 10
 #define STATUS_FILE "/tmp/monitor_status"
+#define INTERVALS_ENV "MONITOR_INTERVALS"          /**< Environment variable overriding group intervals ("cpu=250"). */
+#define WORKERS_ENV "MONITOR_WORKERS"              /**< Environment variable setting the number of collector threads. */
+#define TIMEOUT_ENV "MONITOR_COLLECTOR_TIMEOUT_MS" /**< Environment variable setting the blocking collector timeout. */
+#define IO_URING_ENV "MONITOR_IO_URING"            /**< Environment variable enabling the io_uring batch reader. */
+#define LAZY_ENV "MONITOR_LAZY_MAX_AGE_MS"         /**< Environment variable enabling scrape-driven collection. */
+#define ADAPTIVE_ENV "MONITOR_ADAPTIVE_THRESHOLD"  /**< Environment variable enabling adaptive intervals. */
+#define AGGREGATE_ENV "MONITOR_AGGREGATE"          /**< Environment variable listing groups with window aggregates. */
+#define PROC_ROOT_ENV "MONITOR_PROC_ROOT"          /**< Environment variable setting the directory read as /proc. */
+#define SYS_ROOT_ENV "MONITOR_SYS_ROOT"            /**< Environment variable setting the directory read as /sys. */
+#define RECORD_ENV "MONITOR_RECORD"                /**< Environment variable naming the capture file to record. */
+#define REPLAY_ENV "MONITOR_REPLAY"                /**< Environment variable naming a capture file to replay. */
+#define CPU_BUDGET_ENV "MONITOR_CPU_BUDGET"        /**< Environment variable setting the CPU budget ("0.5%"). */
+#define NET_INCLUDE_ENV "MONITOR_NET_INCLUDE"      /**< Environment variable listing interface patterns to export. */
+#define NET_EXCLUDE_ENV "MONITOR_NET_EXCLUDE"      /**< Environment variable listing interface patterns to skip. */
+#define NET_BACKEND_ENV "MONITOR_NET_BACKEND"      /**< Environment variable selecting "proc" or "netlink" counters. */
 
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <time.h>
 
 // Function to trim leading and trailing whitespace
 char* trim_whitespace(char* str)
@@ -134,59 +160,208 @@ void create_threads(void)
     }
 }
 
-void start_metrics_monitoring(const char* selected_metrics[], size_t num_metrics)
+/**
+ * @brief Parses a decimal environment value that must lie within a range.
+ *
+ * @param value The value of the environment variable.
+ * @param min Smallest accepted number.
+ * @param max Largest accepted number.
+ * @param number Receives the parsed number on success.
+ * @return 0 on success, or -1 if the value is not a number between min and max.
+ */
+static int parse_env_number(const char* value, unsigned long min, unsigned long max, unsigned long* number)
 {
-    init_metrics(selected_metrics, num_metrics);
-
-    create_threads();
-
-    void (*update_functions[num_metrics])(void);
+    char* end;
+    errno = 0;
+    unsigned long parsed = strtoul(value, &end, 10);
+    if (!isdigit((unsigned char)*value) || *end != '\0' || errno != 0 || parsed < min || parsed > max)
+    {
+        return RETURN_ERROR;
+    }
+    *number = parsed;
+    return 0;
+}
 
+void start_metrics_monitoring(const char* selected_metrics[], size_t num_metrics)
+{
     for (size_t i = 0; i < num_metrics; i++)
     {
         const char* metric_name = selected_metrics[i];
-        update_functions[i] = NULL; // Initialize to NULL
 
         printf("Processing metric: '%s'\n", metric_name);
 
-        for (MetricInfo* info = all_metrics; info->name != NULL; info++)
-        {
-
-            if (strcmp(metric_name, info->name) == 0)
-            {
-                update_functions[i] = info->update_function;
-                break;
-            }
-        }
-        if (update_functions[i] == NULL)
+        if (find_metric(metric_name) == NULL)
         {
             char status_message[BUFFER_SIZE];
             snprintf(status_message, sizeof(status_message), "Error: No update function found for metric '%s'",
                      metric_name);
             update_status(status_message);
             fprintf(stderr, "%s\n", status_message);
-            fprintf(stderr, "Error: No update function found for metric '%s'\n", metric_name);
             return;
         }
     }
 
-    update_status("Metrics monitoring started");
+    // Collectors can be pointed at a captured or synthesized tree (see bench/proc_fixture.c) instead of the host
+    if (reader_set_roots(getenv(PROC_ROOT_ENV), getenv(SYS_ROOT_ENV)) != 0)
+    {
+        update_status("Error: " PROC_ROOT_ENV " or " SYS_ROOT_ENV " is too long");
+        return;
+    }
 
-    while (true)
+    // Compiled once here, so hosts with thousands of veth interfaces only pay a few comparisons per interface
+    if (interface_filter_set(getenv(NET_INCLUDE_ENV), getenv(NET_EXCLUDE_ENV)) != 0)
     {
-        for (size_t i = 0; i < num_metrics; i++)
+        update_status("Error: Invalid " NET_INCLUDE_ENV " or " NET_EXCLUDE_ENV);
+        return;
+    }
+
+    if (init_metrics(selected_metrics, num_metrics) != 0)
+    {
+        update_status("Error initializing metrics");
+        return;
+    }
+
+    const char* intervals = getenv(INTERVALS_ENV);
+    if (intervals != NULL && set_group_intervals(intervals) != 0)
+    {
+        update_status("Error: Invalid " INTERVALS_ENV);
+        return;
+    }
+
+    const char* aggregated = getenv(AGGREGATE_ENV);
+    if (aggregated != NULL && set_aggregated_groups(aggregated) != 0)
+    {
+        update_status("Error: Invalid " AGGREGATE_ENV);
+        return;
+    }
+
+    // Any value that is not a positive fraction selects the default threshold
+    const char* adaptive = getenv(ADAPTIVE_ENV);
+    if (adaptive != NULL)
+    {
+        double threshold = strtod(adaptive, NULL);
+        set_adaptive_threshold(threshold > 0 ? threshold : ADAPTIVE_DEFAULT_THRESHOLD);
+    }
+
+    // Either a share of one core ("0.005") or a percentage of one ("0.5%")
+    const char* budget = getenv(CPU_BUDGET_ENV);
+    if (budget != NULL)
+    {
+        char* end;
+        double share = strtod(budget, &end);
+        if (share < 0 || end == budget || (*end != '\0' && strcmp(end, "%") != 0))
         {
-            if (update_functions[i] != NULL)
-            {
-                update_functions[i]();
-            }
-            else
-            {
-                fprintf(stderr, "Error: update_functions[%zu] is NULL\n", i);
-            }
+            update_status("Error: Invalid " CPU_BUDGET_ENV);
+            return;
         }
-        sleep(SLEEP_TIME);
+        set_cpu_budget(*end == '%' ? share / 100 : share);
     }
+
+    const char* max_age = getenv(LAZY_ENV);
+    if (max_age != NULL)
+    {
+        unsigned long max_age_ms;
+        if (parse_env_number(max_age, 0, UINT_MAX, &max_age_ms) != 0)
+        {
+            update_status("Error: Invalid " LAZY_ENV);
+            return;
+        }
+        set_lazy_collection((unsigned int)max_age_ms);
+    }
+
+    // Replay runs the recorded ticks back to back and reports the throughput instead of starting the exporter
+    const char* replay = getenv(REPLAY_ENV);
+    if (replay != NULL)
+    {
+        if (capture_replay_open(replay) != 0)
+        {
+            update_status("Error: Cannot read the capture in " REPLAY_ENV);
+            return;
+        }
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        unsigned long long ticks = replay_collection();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("Replayed %llu ticks in %.3f s (%.0f ticks/s)\n", ticks, seconds, seconds > 0 ? ticks / seconds : 0);
+        capture_close();
+        update_status("Replay finished");
+        return;
+    }
+
+    const char* record = getenv(RECORD_ENV);
+    if (record != NULL && capture_record_start(record) != 0)
+    {
+        update_status("Error: Cannot create the capture in " RECORD_ENV);
+        return;
+    }
+
+    // From here on, errors on the collection path are logged from a background thread
+    if (logger_start() != 0)
+    {
+        fprintf(stderr, "Error starting the logger thread, logging synchronously\n");
+    }
+
+    create_threads();
+
+    const char* io_uring = getenv(IO_URING_ENV);
+    if (io_uring != NULL && strcmp(io_uring, "1") == 0 && batch_reader_init() != 0)
+    {
+        fprintf(stderr, "io_uring is not available, reading with pread\n");
+    }
+
+    // The dump and the link notifications describe this network namespace, not a configured proc root
+    const char* net_backend = getenv(NET_BACKEND_ENV);
+    if (net_backend != NULL && strcmp(net_backend, "netlink") == 0)
+    {
+        if (getenv(PROC_ROOT_ENV) != NULL)
+        {
+            fprintf(stderr, PROC_ROOT_ENV " is set, reading /proc/net/dev below it instead of netlink\n");
+        }
+        else if (netlink_stats_init() != 0)
+        {
+            fprintf(stderr, "netlink is not available, reading /proc/net/dev\n");
+        }
+        else if (!capture_recording())
+        {
+            // The counters come from the dump; batching /proc/net/dev would only have the kernel format it unread
+            all_groups[GROUP_NETWORK].files[0] = NULL;
+        }
+    }
+    if (getenv(PROC_ROOT_ENV) == NULL && watch_interfaces() != 0)
+    {
+        fprintf(stderr, "Cannot track deleted interfaces, their series are kept\n");
+    }
+
+    const char* workers = getenv(WORKERS_ENV);
+    unsigned long num_workers = WORKER_POOL_DEFAULT_SIZE;
+    if (workers != NULL && parse_env_number(workers, 1, WORKER_POOL_MAX_SIZE, &num_workers) != 0)
+    {
+        update_status("Error: Invalid " WORKERS_ENV);
+        return;
+    }
+    const char* timeout = getenv(TIMEOUT_ENV);
+    unsigned long timeout_ms = 0;
+    if (timeout != NULL && parse_env_number(timeout, 1, UINT_MAX, &timeout_ms) != 0)
+    {
+        update_status("Error: Invalid " TIMEOUT_ENV);
+        return;
+    }
+    worker_pool_set_timeout((unsigned int)timeout_ms);
+    if (worker_pool_start(num_workers) != 0)
+    {
+        update_status("Error starting collector workers");
+        return;
+    }
+
+    // Each group runs once per interval, however many of its metrics were selected; in scrape-driven mode only the
+    // groups that keep history are sampled in the background
+    CollectorGroup* groups[GROUP_COUNT];
+    size_t num_groups = get_background_groups(groups, GROUP_COUNT);
+
+    update_status("Metrics monitoring started");
+
+    scheduler_run(groups, num_groups);
 }
 
 /**
@@ -7,132 +7,468 @@
  */
 
 #include "metrics.h"
+#include "capture.h"
+#include "interface_filter.h"
+#include "netlink_stats.h"
+#include "proc_parse.h"
+#include "reader_cache.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+ * @brief Structure to hold one sample of the aggregate cpu history.
+ */
+typedef struct
+{
+    unsigned long long time_ns; /**< CLOCK_MONOTONIC time the counters were sampled at. */
+    CpuTimes times;             /**< Aggregate cpu counters of that sample. */
+} CpuSample;
 
 static double read_value(const char* path)
 {
-    FILE* fp = fopen(path, "r");
-    if (fp == NULL)
+    char buffer[64];
+    if (reader_read(path, buffer, sizeof(buffer)) < 0)
     {
-        perror("Error opening file");
         return RETURN_ERROR;
     }
 
-    int value;
-    if (fscanf(fp, "%d", &value) != 1)
+    long long value;
+    if (parse_s64(buffer, &value) == NULL)
     {
-        fprintf(stderr, "Error reading value from %s\n", path);
-        fclose(fp);
         return RETURN_ERROR;
     }
 
-    fclose(fp);
-    return value / UNIT_CONVERSION;
+    return (double)value / UNIT_CONVERSION;
 }
 
-double get_memory_usage()
+static atomic_ullong current_tick = 1;      /**< Current collection tick; snapshots start out at tick 0. */
+static MeminfoSnapshot meminfo_snapshot;    /**< Parsed /proc/meminfo for the current tick. */
+static ProcStatSnapshot proc_stat_snapshot; /**< Parsed /proc/stat for the current tick. */
+static char* meminfo_buffer = NULL;         /**< Raw contents of /proc/meminfo. */
+static size_t meminfo_capacity = 0;         /**< Allocated size of meminfo_buffer. */
+static char* proc_stat_buffer = NULL;       /**< Raw contents of /proc/stat, tens of KB on large hosts. */
+static size_t proc_stat_capacity = 0;       /**< Allocated size of proc_stat_buffer. */
+static CoreTimes* core_times = NULL;        /**< Per-core lines of proc_stat_snapshot, one contiguous array. */
+static size_t core_times_capacity = 0;      /**< Number of entries allocated in core_times. */
+static char* net_dev_buffer = NULL;         /**< Raw contents of /proc/net/dev. */
+static size_t net_dev_capacity = 0;         /**< Allocated size of net_dev_buffer. */
+static char* diskstats_buffer = NULL;       /**< Raw contents of /proc/diskstats. */
+static size_t diskstats_capacity = 0;       /**< Allocated size of diskstats_buffer. */
+static pthread_mutex_t meminfo_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects meminfo_snapshot and its buffer. */
+static pthread_mutex_t proc_stat_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects proc_stat_snapshot and its buffer. */
+
+static CpuSample cpu_history[CPU_HISTORY_SAMPLES];        /**< Ring of aggregate cpu samples, sample n at n % size. */
+static unsigned long long history_total = 0;              /**< Number of samples recorded so far. */
+static unsigned long long history_now_ns;                 /**< Time proc_stat_snapshot was sampled at. */
+static unsigned long long window_start[CPU_WINDOW_COUNT]; /**< Sample each CpuWindow starts at. */
+static const unsigned int window_seconds[CPU_WINDOW_COUNT] = {1, 10, 60, CPU_HISTORY_SECONDS}; /**< Window lengths. */
+
+void metrics_begin_tick(void)
+{
+    atomic_fetch_add(&current_tick, 1);
+}
+
+unsigned long long metrics_current_tick(void)
+{
+    return atomic_load(&current_tick);
+}
+
+int parse_meminfo(const char* buffer, MeminfoSnapshot* snapshot)
 {
-    FILE* fp = fopen(PROC_MEMINFO_PATH, "r");
-    if (fp == NULL)
+    snapshot->count = 0;
+
+    const char* cursor = buffer;
+    const char* line;
+    size_t length;
+    while ((line = parse_next_line(&cursor, &length)) != NULL && snapshot->count < MEMINFO_MAX_FIELDS)
     {
-        perror("Error opening " PROC_MEMINFO_PATH);
-        return RETURN_ERROR;
+        ParseKey key;
+        const char* rest = parse_key(line, length, ':', &key);
+        MeminfoField* field = &snapshot->fields[snapshot->count];
+        if (rest == NULL || key.length >= MEMINFO_NAME_SIZE || (rest = parse_u64(rest, &field->value)) == NULL)
+        {
+            continue;
+        }
+
+        memcpy(field->name, key.name, key.length);
+        field->name[key.length] = '\0';
+        field->hash = key.hash;
+        rest = parse_skip_spaces(rest);
+        field->in_kb = rest[0] == 'k' && rest[1] == 'B';
+        snapshot->count++;
     }
 
-    char buffer[BUFFER_SIZE];
-    double total_mem = 0, free_mem = 0;
+    return snapshot->count > 0 ? 0 : RETURN_ERROR;
+}
 
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+/**
+ * @brief Re-reads and parses /proc/meminfo into meminfo_snapshot. Called with meminfo_lock held.
+ */
+static void refresh_meminfo_snapshot(unsigned long long tick)
+{
+    meminfo_snapshot.tick = tick;
+    meminfo_snapshot.count = 0;
+    meminfo_snapshot.valid = false;
+
+    if (reader_read_all(PROC_MEMINFO_PATH, &meminfo_buffer, &meminfo_capacity) < 0)
     {
-        if (sscanf(buffer, "MemTotal: %llu kB", &total_mem) == 1)
+        return;
+    }
+
+    meminfo_snapshot.valid = parse_meminfo(meminfo_buffer, &meminfo_snapshot) == 0;
+}
+
+int get_meminfo_snapshot(MeminfoSnapshot* snapshot)
+{
+    pthread_mutex_lock(&meminfo_lock);
+    unsigned long long tick = atomic_load(&current_tick);
+    if (meminfo_snapshot.tick != tick)
+    {
+        refresh_meminfo_snapshot(tick);
+    }
+
+    bool valid = meminfo_snapshot.valid;
+    if (valid)
+    {
+        snapshot->count = meminfo_snapshot.count;
+        snapshot->tick = meminfo_snapshot.tick;
+        snapshot->valid = true;
+        memcpy(snapshot->fields, meminfo_snapshot.fields, meminfo_snapshot.count * sizeof(MeminfoField));
+    }
+    pthread_mutex_unlock(&meminfo_lock);
+
+    return valid ? 0 : RETURN_ERROR;
+}
+
+/**
+ * @brief Parses the eight jiffy counters that follow the name of a cpu line.
+ *
+ * @return true if all of them were present.
+ */
+static bool parse_cpu_times(const char* text, CpuTimes* cpu)
+{
+    unsigned long long* fields[] = {&cpu->user,   &cpu->nice, &cpu->system,  &cpu->idle,
+                                    &cpu->iowait, &cpu->irq,  &cpu->softirq, &cpu->steal};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        if ((text = parse_u64(text, fields[i])) == NULL)
         {
+            return false;
+        }
+    }
+    return true;
+}
+
+int parse_proc_stat(const char* buffer, ProcStatSnapshot* snapshot, CoreTimes* cores, size_t max_cores)
+{
+    const ParseKey cpu_key = PARSE_KEY("cpu");
+    const ParseKey intr_key = PARSE_KEY("intr");
+    const ParseKey ctxt_key = PARSE_KEY("ctxt");
+    const ParseKey processes_key = PARSE_KEY("processes");
+    const ParseKey procs_running_key = PARSE_KEY("procs_running");
+    const ParseKey procs_blocked_key = PARSE_KEY("procs_blocked");
+    const ParseKey softirq_key = PARSE_KEY("softirq");
+
+    bool have_cpu = false;
+    const char* cursor = buffer;
+    const char* line;
+    size_t length;
+    while ((line = parse_next_line(&cursor, &length)) != NULL)
+    {
+        // Per-CPU lines ("cpu0", "cpu1", ...) dominate the file on large hosts; they go straight to the core array
+        if (line[0] == 'c' && line[1] == 'p' && line[2] == 'u' && line[3] != ' ')
+        {
+            unsigned long long id;
+            const char* rest = parse_u64(line + 3, &id);
+            if (cores != NULL && rest != NULL && snapshot->core_count < max_cores)
+            {
+                CoreTimes* core = &cores[snapshot->core_count];
+                core->id = (unsigned int)id;
+                if (!parse_cpu_times(rest, &core->times))
+                {
+                    continue;
+                }
+            }
+            snapshot->core_count++;
             continue;
         }
-        if (sscanf(buffer, "MemAvailable: %llu kB", &free_mem) == 1)
+
+        ParseKey key;
+        const char* rest = parse_key(line, length, ' ', &key);
+        if (rest == NULL)
         {
-            break;
+            continue;
+        }
+
+        if (parse_key_equals(&key, &cpu_key))
+        {
+            have_cpu = parse_cpu_times(rest, &snapshot->cpu);
+        }
+        else if (parse_key_equals(&key, &intr_key))
+        {
+            parse_u64(rest, &snapshot->interrupts);
+        }
+        else if (parse_key_equals(&key, &ctxt_key))
+        {
+            parse_u64(rest, &snapshot->context_switches);
+        }
+        else if (parse_key_equals(&key, &processes_key))
+        {
+            parse_u64(rest, &snapshot->processes);
+        }
+        else if (parse_key_equals(&key, &procs_running_key))
+        {
+            parse_u64(rest, &snapshot->procs_running);
+        }
+        else if (parse_key_equals(&key, &procs_blocked_key))
+        {
+            parse_u64(rest, &snapshot->procs_blocked);
+        }
+        else if (parse_key_equals(&key, &softirq_key))
+        {
+            parse_u64(rest, &snapshot->softirqs);
         }
     }
 
-    fclose(fp);
+    return have_cpu ? 0 : RETURN_ERROR;
+}
 
-    if (total_mem == 0 || free_mem == 0)
+/**
+ * @brief Records the aggregate cpu counters in the history ring and moves the window cursors. Called with
+ * proc_stat_lock held.
+ *
+ * A sample taken less than CPU_HISTORY_RESOLUTION_MS after the newest one in the ring is not kept, which bounds the
+ * ring whatever the collection interval; it only serves as the end of the windows until the next snapshot. Each
+ * cursor only moves forward, to the newest sample at least its window old, so all the moves together cost no more
+ * than one step per recorded sample and window.
+ */
+static void record_cpu_history(const CpuTimes* times)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    history_now_ns = (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+
+    if (history_total == 0 ||
+        history_now_ns >= cpu_history[(history_total - 1) % CPU_HISTORY_SAMPLES].time_ns +
+                              CPU_HISTORY_RESOLUTION_MS * 1000000ULL)
+    {
+        cpu_history[history_total % CPU_HISTORY_SAMPLES] = (CpuSample){history_now_ns, *times};
+        history_total++;
+    }
+
+    unsigned long long oldest = history_total > CPU_HISTORY_SAMPLES ? history_total - CPU_HISTORY_SAMPLES : 0;
+    for (size_t window = 0; window < CPU_WINDOW_COUNT; window++)
+    {
+        unsigned long long span = (unsigned long long)window_seconds[window] * 1000000000ULL;
+        unsigned long long start = window_start[window] > oldest ? window_start[window] : oldest;
+        while (start + 1 < history_total &&
+               cpu_history[(start + 1) % CPU_HISTORY_SAMPLES].time_ns + span <= history_now_ns)
+        {
+            start++;
+        }
+        window_start[window] = start;
+    }
+}
+
+/**
+ * @brief Retrieves the CPU usage since the start of a window. Called with proc_stat_lock held.
+ *
+ * @return CPU usage as a percentage, or -1.0 if there is no snapshot or no time has elapsed since the window start.
+ */
+static double cpu_window_usage(CpuWindow window)
+{
+    if (!proc_stat_snapshot.valid || history_total == 0)
     {
-        fprintf(stderr, "Error reading memory information from " PROC_MEMINFO_PATH "\n");
         return RETURN_ERROR;
     }
+    return cpu_times_usage(&cpu_history[window_start[window] % CPU_HISTORY_SAMPLES].times, &proc_stat_snapshot.cpu);
+}
 
-    double used_mem = (total_mem - free_mem);
-    double mem_usage_percent = (used_mem / total_mem) * 100.0;
+/**
+ * @brief Re-reads and parses /proc/stat into proc_stat_snapshot. Called with proc_stat_lock held.
+ */
+static void refresh_proc_stat_snapshot(unsigned long long tick)
+{
+    memset(&proc_stat_snapshot, 0, sizeof(proc_stat_snapshot));
+    proc_stat_snapshot.tick = tick;
 
-    return mem_usage_percent;
+    if (reader_read_all(PROC_STAT_PATH, &proc_stat_buffer, &proc_stat_capacity) < 0)
+    {
+        return;
+    }
+
+    proc_stat_snapshot.valid =
+        parse_proc_stat(proc_stat_buffer, &proc_stat_snapshot, core_times, core_times_capacity) == 0;
+    if (proc_stat_snapshot.valid && proc_stat_snapshot.core_count > core_times_capacity)
+    {
+        // First read, or cores came online: size the array once and parse again
+        CoreTimes* grown = realloc(core_times, proc_stat_snapshot.core_count * sizeof(CoreTimes));
+        if (grown != NULL)
+        {
+            core_times = grown;
+            core_times_capacity = proc_stat_snapshot.core_count;
+            proc_stat_snapshot.core_count = 0;
+            parse_proc_stat(proc_stat_buffer, &proc_stat_snapshot, core_times, core_times_capacity);
+        }
+    }
+    if (proc_stat_snapshot.valid)
+    {
+        record_cpu_history(&proc_stat_snapshot.cpu);
+    }
 }
 
-double get_cpu_usage()
+int get_proc_stat_snapshot(ProcStatSnapshot* snapshot)
 {
-    static double prev_user = 0, prev_nice = 0, prev_system = 0, prev_idle = 0, prev_iowait = 0, prev_irq = 0,
-                  prev_softirq = 0, prev_steal = 0;
-    double user, nice, system, idle, iowait, irq, softirq, steal;
+    pthread_mutex_lock(&proc_stat_lock);
+    unsigned long long tick = atomic_load(&current_tick);
+    if (proc_stat_snapshot.tick != tick)
+    {
+        refresh_proc_stat_snapshot(tick);
+    }
 
-    FILE* fp = fopen(PROC_STAT_PATH, "r");
-    if (fp == NULL)
+    bool valid = proc_stat_snapshot.valid;
+    if (valid)
     {
-        perror("Error opening " PROC_STAT_PATH);
-        return RETURN_ERROR;
+        *snapshot = proc_stat_snapshot;
     }
+    pthread_mutex_unlock(&proc_stat_lock);
 
-    char buffer[BUFFER_SIZE * 4];
-    if (fgets(buffer, sizeof(buffer), fp) == NULL)
+    return valid ? 0 : RETURN_ERROR;
+}
+
+ssize_t get_core_times(CoreTimes** cores, size_t* capacity)
+{
+    pthread_mutex_lock(&proc_stat_lock);
+    unsigned long long tick = atomic_load(&current_tick);
+    if (proc_stat_snapshot.tick != tick)
+    {
+        refresh_proc_stat_snapshot(tick);
+    }
+
+    ssize_t count = RETURN_ERROR;
+    if (proc_stat_snapshot.valid)
+    {
+        size_t available = proc_stat_snapshot.core_count < core_times_capacity ? proc_stat_snapshot.core_count
+                                                                                : core_times_capacity;
+        if (*capacity < available)
+        {
+            CoreTimes* grown = realloc(*cores, available * sizeof(CoreTimes));
+            if (grown != NULL)
+            {
+                *cores = grown;
+                *capacity = available;
+            }
+        }
+        count = (ssize_t)(available < *capacity ? available : *capacity);
+        memcpy(*cores, core_times, (size_t)count * sizeof(CoreTimes));
+    }
+    pthread_mutex_unlock(&proc_stat_lock);
+
+    return count;
+}
+
+double cpu_times_usage(const CpuTimes* previous, const CpuTimes* current)
+{
+    unsigned long long previous_idle = previous->idle + previous->iowait;
+    unsigned long long idle = current->idle + current->iowait;
+    unsigned long long previous_busy = previous->user + previous->nice + previous->system + previous->irq +
+                                       previous->softirq + previous->steal;
+    unsigned long long busy =
+        current->user + current->nice + current->system + current->irq + current->softirq + current->steal;
+
+    // Counters can step back slightly when a core goes offline and comes back; treat that as no elapsed time
+    if (idle + busy <= previous_idle + previous_busy || idle < previous_idle || busy < previous_busy)
     {
-        perror("Error reading " PROC_STAT_PATH);
-        fclose(fp);
         return RETURN_ERROR;
     }
-    fclose(fp);
+    double total = (double)(idle + busy - previous_idle - previous_busy);
+    return (double)(busy - previous_busy) / total * PERCENTAGE;
+}
 
-    int ret = sscanf(buffer, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait,
-                     &irq, &softirq, &steal);
-    if (ret < 8)
+int meminfo_lookup(const MeminfoSnapshot* snapshot, ParseKey key, unsigned long long* value)
+{
+    for (size_t i = 0; i < snapshot->count; i++)
+    {
+        const MeminfoField* field = &snapshot->fields[i];
+        if (field->hash == key.hash && memcmp(field->name, key.name, key.length + 1) == 0)
+        {
+            *value = field->value;
+            return 0;
+        }
+    }
+    return RETURN_ERROR;
+}
+
+double get_memory_usage()
+{
+    MeminfoSnapshot snapshot;
+    if (get_meminfo_snapshot(&snapshot) != 0)
     {
-        fprintf(stderr, "Error parsing " PROC_STAT_PATH "\n");
         return RETURN_ERROR;
     }
 
-    double prev_idle_total = prev_idle + prev_iowait;
-    double idle_total = idle + iowait;
-    double prev_non_idle = prev_user + prev_nice + prev_system + prev_irq + prev_softirq + prev_steal;
-    double non_idle = user + nice + system + irq + softirq + steal;
-    double prev_total = prev_idle_total + prev_non_idle;
-    double total = idle_total + non_idle;
-    double totald = total - prev_total;
-    double idled = idle_total - prev_idle_total;
+    unsigned long long total_mem = 0, free_mem = 0;
+    meminfo_lookup(&snapshot, PARSE_KEY("MemTotal"), &total_mem);
+    meminfo_lookup(&snapshot, PARSE_KEY("MemAvailable"), &free_mem);
 
-    if (totald == 0)
+    if (total_mem == 0 || free_mem == 0)
     {
-        fprintf(stderr, "Totald is zero, cannot calculate CPU usage!\n");
         return RETURN_ERROR;
     }
 
-    double cpu_usage_percent = ((totald - idled) / totald) * 100.0;
+    double used_mem = (double)(total_mem - free_mem);
+    double mem_usage_percent = (used_mem / (double)total_mem) * 100.0;
 
-    prev_user = user;
-    prev_nice = nice;
-    prev_system = system;
-    prev_idle = idle;
-    prev_iowait = iowait;
-    prev_irq = irq;
-    prev_softirq = softirq;
-    prev_steal = steal;
+    return mem_usage_percent;
+}
+
+double get_cpu_usage()
+{
+    pthread_mutex_lock(&proc_stat_lock);
+    unsigned long long tick = atomic_load(&current_tick);
+    if (proc_stat_snapshot.tick != tick)
+    {
+        refresh_proc_stat_snapshot(tick);
+    }
+
+    double cpu_usage_percent = cpu_window_usage(CPU_WINDOW_1S);
+    if (cpu_usage_percent < 0 && proc_stat_snapshot.valid)
+    {
+        // First sample: usage since boot, as the first call always reported
+        cpu_usage_percent = cpu_times_usage(&(CpuTimes){0}, &proc_stat_snapshot.cpu);
+    }
+    pthread_mutex_unlock(&proc_stat_lock);
 
     return cpu_usage_percent;
 }
 
+int get_cpu_window_usage(double usage[CPU_WINDOW_COUNT])
+{
+    pthread_mutex_lock(&proc_stat_lock);
+    unsigned long long tick = atomic_load(&current_tick);
+    if (proc_stat_snapshot.tick != tick)
+    {
+        refresh_proc_stat_snapshot(tick);
+    }
+
+    bool valid = proc_stat_snapshot.valid;
+    for (size_t window = 0; window < CPU_WINDOW_COUNT; window++)
+    {
+        usage[window] = cpu_window_usage((CpuWindow)window);
+    }
+    pthread_mutex_unlock(&proc_stat_lock);
+
+    return valid ? 0 : RETURN_ERROR;
+}
+
 double get_disk_usage()
 {
     struct statvfs stat;
 
     if (statvfs(ROOT_PATH, &stat) != 0)
     {
-        fprintf(stderr, "Error getting file system statistics\n");
         return RETURN_ERROR;
     }
 
@@ -174,36 +510,40 @@ double get_gpu_fan_speed()
     return read_value(GPU_FAN_SPEED_PATH) * UNIT_CONVERSION;
 }
 
-void get_process_states(int* total, int* suspended, int* ready, int* blocked)
+int get_process_states(int* total, int* suspended, int* ready, int* blocked)
 {
-    DIR* proc_dir = opendir(PROC_DIR_PATH);
-    if (proc_dir == NULL)
+    char* entries = NULL;
+    size_t capacity = 0;
+    if (reader_read_directory(PROC_DIR_PATH, &entries, &capacity) < 0)
     {
-        perror("Error opening " PROC_DIR_PATH);
-        return;
+        return RETURN_ERROR;
     }
 
-    struct dirent* entry;
     *total = 0;
     *suspended = 0;
     *ready = 0;
     *blocked = 0;
 
-    while ((entry = readdir(proc_dir)) != NULL)
+    char* next;
+    for (char* name = entries; *name != '\0'; name = next)
     {
-        if (isdigit(entry->d_name[0]))
+        next = strchr(name, '\n');
+        *next++ = '\0';
+        if (isdigit((unsigned char)name[0]))
         {
             char path[BUFFER_SIZE];
-            snprintf(path, sizeof(path), STAT_FILE_FORMAT, entry->d_name);
+            snprintf(path, sizeof(path), STAT_FILE_FORMAT, name);
 
-            FILE* fp = fopen(path, "r");
-            if (fp == NULL)
+            char buffer[BUFFER_SIZE];
+            if (reader_read_transient(path, buffer, sizeof(buffer)) < 0)
             {
                 continue;
             }
 
-            char state;
-            if (fscanf(fp, "%*d %*s %c", &state) == 1)
+            // The command name may contain spaces, so the state is taken after its closing parenthesis.
+            const char* comm_end = strrchr(buffer, ')');
+            char state = comm_end != NULL ? *parse_skip_spaces(comm_end + 1) : '\0';
+            if (state != '\0')
             {
                 (*total)++;
                 if (state == 'S')
@@ -219,179 +559,179 @@ void get_process_states(int* total, int* suspended, int* ready, int* blocked)
                     (*blocked)++;
                 }
             }
-
-            fclose(fp);
         }
     }
 
-    closedir(proc_dir);
+    free(entries);
+    return 0;
 }
 
 double get_total_memory()
 {
-    FILE* fp = fopen(PROC_MEMINFO_PATH, "r");
-    if (fp == NULL)
+    MeminfoSnapshot snapshot;
+    if (get_meminfo_snapshot(&snapshot) != 0)
     {
-        perror("Error opening " PROC_MEMINFO_PATH);
         return RETURN_ERROR;
     }
 
-    char buffer[BUFFER_SIZE];
-    double total_mem = 0;
-
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        if (sscanf(buffer, "MemTotal: %llu kB", &total_mem) == 1)
-        {
-            break;
-        }
-    }
-
-    fclose(fp);
-    return total_mem / CONVERT_TO_MB;
+    unsigned long long total_mem = 0;
+    meminfo_lookup(&snapshot, PARSE_KEY("MemTotal"), &total_mem);
+    return (double)total_mem / CONVERT_TO_MB;
 }
 
 double get_used_memory()
 {
-    FILE* fp = fopen(PROC_MEMINFO_PATH, "r");
-    if (fp == NULL)
+    MeminfoSnapshot snapshot;
+    if (get_meminfo_snapshot(&snapshot) != 0)
     {
-        perror("Error opening " PROC_MEMINFO_PATH);
         return RETURN_ERROR;
     }
 
-    char buffer[BUFFER_SIZE];
-    double total_mem = 0, free_mem = 0, buffers = 0, cached = 0;
-
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        sscanf(buffer, "MemTotal: %llu kB", &total_mem);
-        sscanf(buffer, "MemFree: %llu kB", &free_mem);
-        sscanf(buffer, "Buffers: %llu kB", &buffers);
-        sscanf(buffer, "Cached: %llu kB", &cached);
-    }
-
-    fclose(fp);
-    return (total_mem - free_mem - buffers - cached) / CONVERT_TO_MB;
+    unsigned long long total_mem = 0, free_mem = 0, buffers = 0, cached = 0;
+    meminfo_lookup(&snapshot, PARSE_KEY("MemTotal"), &total_mem);
+    meminfo_lookup(&snapshot, PARSE_KEY("MemFree"), &free_mem);
+    meminfo_lookup(&snapshot, PARSE_KEY("Buffers"), &buffers);
+    meminfo_lookup(&snapshot, PARSE_KEY("Cached"), &cached);
+    return ((double)total_mem - (double)free_mem - (double)buffers - (double)cached) / CONVERT_TO_MB;
 }
 
 double get_available_memory()
 {
-    FILE* fp = fopen(PROC_MEMINFO_PATH, "r");
-    if (fp == NULL)
+    MeminfoSnapshot snapshot;
+    if (get_meminfo_snapshot(&snapshot) != 0)
     {
-        perror("Error opening " PROC_MEMINFO_PATH);
         return RETURN_ERROR;
     }
 
-    char buffer[BUFFER_SIZE];
-    double available_mem = 0;
+    unsigned long long available_mem = 0;
+    meminfo_lookup(&snapshot, PARSE_KEY("MemAvailable"), &available_mem);
+    return (double)available_mem / CONVERT_TO_MB;
+}
 
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+InterfaceStats* reserve_interface(InterfaceStats** interfaces, size_t* capacity, size_t count)
+{
+    if (count == *capacity)
     {
-        if (sscanf(buffer, "MemAvailable: %llu kB", &available_mem) == 1)
+        size_t grown_capacity = *capacity > 0 ? *capacity * 2 : INTERFACE_INITIAL_CAPACITY;
+        InterfaceStats* grown = realloc(*interfaces, grown_capacity * sizeof(InterfaceStats));
+        if (grown == NULL)
         {
-            break;
+            return NULL;
         }
+        *interfaces = grown;
+        *capacity = grown_capacity;
     }
-
-    fclose(fp);
-    return available_mem / CONVERT_TO_MB;
+    return &(*interfaces)[count];
 }
 
-NetworkStats get_network_traffic()
+ssize_t parse_net_dev(const char* buffer, InterfaceStats** interfaces, size_t* capacity)
 {
-    FILE* fp = fopen(PROC_NET_DEV_PATH, "r");
-    if (fp == NULL)
-    {
-        perror("Error opening " PROC_NET_DEV_PATH);
-        return (NetworkStats){RETURN_ERROR, RETURN_ERROR, RETURN_ERROR, RETURN_ERROR, RETURN_ERROR};
-    }
-
-    char buffer[BUFFER_SIZE];
-    unsigned long long rx_bytes = 0, tx_bytes = 0;
-    unsigned long long rx_errors = 0, tx_errors = 0, dropped_packets = 0;
-
-    fgets(buffer, sizeof(buffer), fp);
-    fgets(buffer, sizeof(buffer), fp);
-
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    size_t count = 0;
+    const char* cursor = buffer;
+    const char* line;
+    size_t length;
+    while ((line = parse_next_line(&cursor, &length)) != NULL)
     {
-        if (strstr(buffer, NETWORK_INTERFACE) != NULL)
+        // The two header lines have no colon and are skipped here; so are interfaces the filter leaves out
+        ParseKey key;
+        const char* rest = parse_key(line, length, ':', &key);
+        if (rest == NULL || key.length == 0 || key.length >= INTERFACE_NAME_SIZE ||
+            !interface_filter_match(key.name, key.length))
         {
-            unsigned long long r_bytes, t_bytes, r_errors, t_errors, drop;
-
-            int matched = sscanf(buffer, "%*[^:]: %llu %*d %llu %llu %*d %*d %*d %*d %llu %*d %llu", &r_bytes,
-                                 &r_errors, &drop, &t_bytes, &t_errors);
-
-            if (matched != 5)
-            {
-                fprintf(stderr, "sscanf failed to match expected format (matched = %d) for line: %s\n", matched,
-                        buffer);
-                continue;
-            }
-
-            rx_bytes = r_bytes;
-            tx_bytes = t_bytes;
-            rx_errors = r_errors;
-            tx_errors = t_errors;
-            dropped_packets = drop;
+            continue;
+        }
 
-            break;
+        InterfaceStats* stats = reserve_interface(interfaces, capacity, count);
+        if (stats == NULL)
+        {
+            return RETURN_ERROR;
+        }
+        size_t counter = 0;
+        while (counter < NET_DEV_COUNTERS && (rest = parse_u64(rest, &stats->counters[counter])) != NULL)
+        {
+            counter++;
+        }
+        if (counter < NET_DEV_COUNTERS)
+        {
+            continue;
         }
+        memcpy(stats->name, key.name, key.length);
+        stats->name[key.length] = '\0';
+        count++;
     }
-
-    fclose(fp);
-    return (NetworkStats){rx_bytes, tx_bytes, rx_errors, tx_errors, dropped_packets};
+    return (ssize_t)count;
 }
 
-int get_context_switches()
+ssize_t get_interface_stats(InterfaceStats** interfaces, size_t* capacity)
 {
-    FILE* fp = fopen(PROC_STAT_PATH, "r");
-    if (fp == NULL)
+    // Captures hold file contents, so recording and replaying keep going through /proc/net/dev
+    if (netlink_stats_enabled() && !capture_recording() && !capture_replaying())
     {
-        perror("Error opening /proc/stat");
-        return RETURN_ERROR;
+        ssize_t count = netlink_stats_read(interfaces, capacity);
+        if (count >= 0)
+        {
+            return count;
+        }
     }
 
-    char buffer[BUFFER_SIZE];
-    int context_switches = 0;
-
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    if (reader_read_all(PROC_NET_DEV_PATH, &net_dev_buffer, &net_dev_capacity) < 0)
     {
-        if (sscanf(buffer, "ctxt %d", &context_switches) == 1)
-        {
-            break;
-        }
+        return RETURN_ERROR;
     }
+    return parse_net_dev(net_dev_buffer, interfaces, capacity);
+}
 
-    fclose(fp);
-    return context_switches;
+long long get_context_switches()
+{
+    ProcStatSnapshot snapshot;
+    if (get_proc_stat_snapshot(&snapshot) != 0)
+    {
+        return RETURN_ERROR;
+    }
+    return (long long)snapshot.context_switches;
 }
 
-DiskStats get_disk_stats()
+long long get_running_processes()
 {
-    FILE* fp = fopen(DISKSTATS_PATH, "r");
-    if (fp == NULL)
+    ProcStatSnapshot snapshot;
+    if (get_proc_stat_snapshot(&snapshot) != 0)
     {
-        perror("Error opening " DISKSTATS_PATH);
-        return (DiskStats){RETURN_ERROR, RETURN_ERROR, RETURN_ERROR};
+        return RETURN_ERROR;
     }
+    return (long long)snapshot.procs_running;
+}
 
-    char buffer[BUFFER_SIZE];
-    unsigned long long io_time = 0, writes_completed = 0, reads_completed = 0;
+void parse_diskstats(const char* buffer, DiskStats* stats)
+{
+    *stats = (DiskStats){0, 0, 0};
 
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    const char* cursor = buffer;
+    const char* line;
+    size_t length;
+    while ((line = parse_next_line(&cursor, &length)) != NULL)
     {
-        long long it, wc, rc;
-        if (sscanf(buffer, "%*d %*d %*s %lld %*d %*d %*d %lld %*d %lld", &rc, &wc, &it) == 3)
+        // major minor name, then the I/O counters
+        unsigned long long rc, wc, it;
+        const char* rest = parse_skip_fields(line, 3);
+        if (rest == NULL || (rest = parse_u64(rest, &rc)) == NULL || (rest = parse_skip_fields(rest, 3)) == NULL ||
+            (rest = parse_u64(rest, &wc)) == NULL || (rest = parse_skip_fields(rest, 1)) == NULL ||
+            parse_u64(rest, &it) == NULL)
         {
-            reads_completed += rc;
-            writes_completed += wc;
-            io_time += it;
+            continue;
         }
+
+        stats->reads_completed += rc;
+        stats->writes_completed += wc;
+        stats->io_time += it;
     }
+}
 
-    fclose(fp);
-    return (DiskStats){io_time, writes_completed, reads_completed};
+DiskStats get_disk_stats()
+{
+    DiskStats stats = {RETURN_ERROR, RETURN_ERROR, RETURN_ERROR};
+    if (reader_read_all(DISKSTATS_PATH, &diskstats_buffer, &diskstats_capacity) >= 0)
+    {
+        parse_diskstats(diskstats_buffer, &stats);
+    }
+    return stats;
 }
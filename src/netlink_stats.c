@@ -0,0 +1,717 @@
+/**
+ * @file netlink_stats.c
+ * @brief Per-interface network counters from rtnetlink dumps on a persistent socket.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "netlink_stats.h"
+#include "interface_filter.h"
+#include "logger.h"
+#include <errno.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief Structure to hold the name of a link, keyed by its index.
+ */
+typedef struct
+{
+    int index;                      /**< Interface index, 0 for a free slot. */
+    bool seen;                      /**< Whether the running name dump listed the link. */
+    char name[INTERFACE_NAME_SIZE]; /**< Interface name. */
+} LinkName;
+
+/**
+ * @brief Structure to hold the destination of a dump that collects interface counters.
+ */
+typedef struct
+{
+    InterfaceStats** interfaces; /**< The caller's array. */
+    size_t* capacity;            /**< Number of entries allocated in the array. */
+    size_t count;                /**< Number of entries filled. */
+    bool unknown_link;           /**< Whether a link was missing from the name table. */
+} DumpTarget;
+
+/**
+ * @brief Handles one message of a dump.
+ *
+ * @return false to abort the dump, with errno set.
+ */
+typedef bool (*MessageHandler)(const struct nlmsghdr* header, void* context);
+
+static int netlink_socket = -1;                                  /**< The persistent socket, -1 until (re)opened. */
+static atomic_bool enabled = false;                              /**< Whether the backend is in use. */
+static char* receive_buffer = NULL;                              /**< Receive buffer, NETLINK_RECEIVE_SIZE bytes. */
+static unsigned int sequence = 0;                                /**< Sequence number of the last dump request. */
+static bool stats_dump_supported = true;                         /**< Whether the kernel answers RTM_GETSTATS. */
+static LinkName* link_names = NULL;                              /**< Open-addressing table of link names. */
+static size_t link_names_size = 0;                               /**< Slots in link_names (power of two). */
+static size_t link_name_count = 0;                               /**< Occupied slots in link_names. */
+static pthread_mutex_t netlink_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects everything above but enabled. */
+
+static int event_socket = -1;                     /**< Socket subscribed to RTMGRP_LINK, -1 unless watching. */
+static LinkRemovedHandler removed_handler = NULL; /**< Called for every link deleted or renamed while watching. */
+static bool resync_pending = false;               /**< Whether notifications were lost since the last name dump. */
+
+/**
+ * @brief Opens and binds a NETLINK_ROUTE socket.
+ *
+ * @param groups Multicast groups to join, 0 for a socket that only dumps; a subscribed socket does not block.
+ * @return The socket, or -1 in case of error.
+ */
+static int open_socket(unsigned int groups)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | (groups != 0 ? SOCK_NONBLOCK : 0), NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int size = NETLINK_SOCKET_BUFFER_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)); // Best effort; the default fits small hosts
+    struct sockaddr_nl local = {.nl_family = AF_NETLINK, .nl_groups = groups};
+    if (bind(fd, (struct sockaddr*)&local, sizeof(local)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Retrieves the slot a link index hashes to in a name table of the given size.
+ */
+static size_t home_slot(int index, size_t size)
+{
+    return ((unsigned int)index * 2654435761u) & (size - 1);
+}
+
+/**
+ * @brief Finds the slot of a link index in the name table: its own, or the free slot where it belongs.
+ */
+static LinkName* find_slot(LinkName* table, size_t size, int index)
+{
+    size_t slot = home_slot(index, size);
+    while (table[slot].index != 0 && table[slot].index != index)
+    {
+        slot = (slot + 1) & (size - 1);
+    }
+    return &table[slot];
+}
+
+/**
+ * @brief Reports a link that no longer exists under its name to the watcher, if any.
+ */
+static void report_removed(const char* name)
+{
+    if (removed_handler != NULL)
+    {
+        removed_handler(name);
+    }
+}
+
+/**
+ * @brief Records the name of a link, growing the table past half full. A rename reports the old name as removed.
+ *
+ * @return 0 on success, or -1 if the table could not grow.
+ */
+static int set_link_name(int index, const char* name, size_t length)
+{
+    if ((link_name_count + 1) * 2 > link_names_size)
+    {
+        size_t size = link_names_size > 0 ? link_names_size * 2 : NETLINK_NAME_TABLE_SIZE;
+        LinkName* table = calloc(size, sizeof(LinkName));
+        if (table == NULL)
+        {
+            return -1;
+        }
+        for (size_t i = 0; i < link_names_size; i++)
+        {
+            if (link_names[i].index != 0)
+            {
+                *find_slot(table, size, link_names[i].index) = link_names[i];
+            }
+        }
+        free(link_names);
+        link_names = table;
+        link_names_size = size;
+    }
+
+    LinkName* entry = find_slot(link_names, link_names_size, index);
+    if (entry->index == 0)
+    {
+        entry->index = index;
+        link_name_count++;
+    }
+    else if (strncmp(entry->name, name, length) != 0 || entry->name[length] != '\0')
+    {
+        report_removed(entry->name);
+    }
+    entry->seen = true;
+    memcpy(entry->name, name, length);
+    entry->name[length] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Removes a link from the name table, shifting back the entries that probed past its slot.
+ */
+static void remove_link_name(LinkName* entry)
+{
+    size_t mask = link_names_size - 1;
+    size_t hole = (size_t)(entry - link_names);
+    for (size_t slot = (hole + 1) & mask; link_names[slot].index != 0; slot = (slot + 1) & mask)
+    {
+        // An entry may fill the hole unless its home slot lies between the hole and itself
+        if (((slot - home_slot(link_names[slot].index, link_names_size)) & mask) >= ((slot - hole) & mask))
+        {
+            link_names[hole] = link_names[slot];
+            hole = slot;
+        }
+    }
+    link_names[hole].index = 0;
+    link_name_count--;
+}
+
+/**
+ * @brief Looks up the name of a link.
+ *
+ * @return The name, or NULL if the link is not in the table.
+ */
+static const char* get_link_name(int index)
+{
+    if (link_names_size == 0)
+    {
+        return NULL;
+    }
+    LinkName* entry = find_slot(link_names, link_names_size, index);
+    return entry->index == index ? entry->name : NULL;
+}
+
+/**
+ * @brief Folds IFLA_STATS64 into the sixteen /proc/net/dev counters, the way the kernel formats that file.
+ */
+static void fold_counters(const struct rtnl_link_stats64* stats, unsigned long long counters[])
+{
+    counters[NET_RX_BYTES] = stats->rx_bytes;
+    counters[NET_RX_PACKETS] = stats->rx_packets;
+    counters[NET_RX_ERRORS] = stats->rx_errors;
+    counters[NET_RX_DROPPED] = stats->rx_dropped + stats->rx_missed_errors;
+    counters[NET_RX_FIFO] = stats->rx_fifo_errors;
+    counters[NET_RX_FRAME] =
+        stats->rx_length_errors + stats->rx_over_errors + stats->rx_crc_errors + stats->rx_frame_errors;
+    counters[NET_RX_COMPRESSED] = stats->rx_compressed;
+    counters[NET_RX_MULTICAST] = stats->multicast;
+    counters[NET_TX_BYTES] = stats->tx_bytes;
+    counters[NET_TX_PACKETS] = stats->tx_packets;
+    counters[NET_TX_ERRORS] = stats->tx_errors;
+    counters[NET_TX_DROPPED] = stats->tx_dropped;
+    counters[NET_TX_FIFO] = stats->tx_fifo_errors;
+    counters[NET_TX_COLLISIONS] = stats->collisions;
+    counters[NET_TX_CARRIER] = stats->tx_carrier_errors + stats->tx_aborted_errors + stats->tx_window_errors +
+                               stats->tx_heartbeat_errors;
+    counters[NET_TX_COMPRESSED] = stats->tx_compressed;
+}
+
+/**
+ * @brief Copies a struct rtnl_link_stats64 attribute.
+ *
+ * Copied rather than cast: attributes are only 4-byte aligned, and older kernels send a shorter struct.
+ *
+ * @return true if the attribute holds at least every counter /proc/net/dev shows.
+ */
+static bool copy_stats64(const struct rtattr* attribute, struct rtnl_link_stats64* stats)
+{
+    size_t payload = RTA_PAYLOAD(attribute);
+    if (payload < offsetof(struct rtnl_link_stats64, rx_nohandler))
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    memcpy(stats, RTA_DATA(attribute), payload < sizeof(*stats) ? payload : sizeof(*stats));
+    return true;
+}
+
+/**
+ * @brief Appends the counters of a link to a dump target if the interface filter selects it.
+ *
+ * @return false if the target could not grow.
+ */
+static bool append_link(DumpTarget* target, const char* name, size_t length, const struct rtnl_link_stats64* stats)
+{
+    if (length == 0 || length >= INTERFACE_NAME_SIZE || !interface_filter_match(name, length))
+    {
+        return true;
+    }
+    InterfaceStats* link = reserve_interface(target->interfaces, target->capacity, target->count);
+    if (link == NULL)
+    {
+        errno = ENOMEM;
+        return false;
+    }
+    memcpy(link->name, name, length);
+    link->name[length] = '\0';
+    fold_counters(stats, link->counters);
+    target->count++;
+    return true;
+}
+
+/**
+ * @brief Finds the name of an RTM_NEWLINK message.
+ *
+ * @return The name, not necessarily NUL-terminated, or NULL if the message has none.
+ */
+static const char* link_message_name(const struct nlmsghdr* header, size_t* length)
+{
+    const struct ifinfomsg* info = NLMSG_DATA(header);
+    int remaining = (int)header->nlmsg_len - (int)NLMSG_LENGTH(sizeof(*info));
+    for (const struct rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, remaining);
+         attribute = RTA_NEXT(attribute, remaining))
+    {
+        if (attribute->rta_type == IFLA_IFNAME)
+        {
+            *length = strnlen(RTA_DATA(attribute), RTA_PAYLOAD(attribute));
+            return RTA_DATA(attribute);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Handler keeping the name table current from RTM_NEWLINK and RTM_DELLINK messages, dumped or notified.
+ *
+ * Only AF_UNSPEC messages describe the link itself: a bridge also sends AF_BRIDGE ones when ports join or leave it.
+ */
+static bool handle_name(const struct nlmsghdr* header, void* context)
+{
+    (void)context;
+    const struct ifinfomsg* info = NLMSG_DATA(header);
+    if ((header->nlmsg_type != RTM_NEWLINK && header->nlmsg_type != RTM_DELLINK) ||
+        header->nlmsg_len < NLMSG_LENGTH(sizeof(*info)) || info->ifi_family != AF_UNSPEC)
+    {
+        return true;
+    }
+
+    if (header->nlmsg_type == RTM_DELLINK)
+    {
+        const char* name = get_link_name(info->ifi_index);
+        if (name != NULL)
+        {
+            report_removed(name);
+            remove_link_name(find_slot(link_names, link_names_size, info->ifi_index));
+        }
+        return true;
+    }
+
+    size_t length;
+    const char* name = link_message_name(header, &length);
+    if (name == NULL || length == 0 || length >= INTERFACE_NAME_SIZE)
+    {
+        return true;
+    }
+    if (set_link_name(info->ifi_index, name, length) != 0)
+    {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Dump handler collecting counters from RTM_NEWSTATS messages, naming links through the name table.
+ */
+static bool handle_stats(const struct nlmsghdr* header, void* context)
+{
+    DumpTarget* target = context;
+    if (header->nlmsg_type != RTM_NEWSTATS)
+    {
+        return true;
+    }
+
+    const struct if_stats_msg* message = NLMSG_DATA(header);
+    const char* name = get_link_name((int)message->ifindex);
+    if (name == NULL)
+    {
+        target->unknown_link = true; // Created since the names were last dumped
+        return true;
+    }
+
+    int remaining = (int)header->nlmsg_len - (int)NLMSG_LENGTH(sizeof(*message));
+    const struct rtattr* attribute =
+        (const struct rtattr*)((const char*)message + NLMSG_ALIGN(sizeof(struct if_stats_msg)));
+    for (; RTA_OK(attribute, remaining); attribute = RTA_NEXT(attribute, remaining))
+    {
+        struct rtnl_link_stats64 stats;
+        if (attribute->rta_type == IFLA_STATS_LINK_64 && copy_stats64(attribute, &stats))
+        {
+            return append_link(target, name, strlen(name), &stats);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Dump handler collecting counters from the IFLA_STATS64 attribute of RTM_NEWLINK messages.
+ */
+static bool handle_link(const struct nlmsghdr* header, void* context)
+{
+    if (header->nlmsg_type != RTM_NEWLINK)
+    {
+        return true;
+    }
+
+    const struct ifinfomsg* info = NLMSG_DATA(header);
+    int remaining = (int)header->nlmsg_len - (int)NLMSG_LENGTH(sizeof(*info));
+    size_t length;
+    const char* name = link_message_name(header, &length);
+    for (const struct rtattr* attribute = IFLA_RTA(info); name != NULL && RTA_OK(attribute, remaining);
+         attribute = RTA_NEXT(attribute, remaining))
+    {
+        struct rtnl_link_stats64 stats;
+        if (attribute->rta_type == IFLA_STATS64 && copy_stats64(attribute, &stats))
+        {
+            return append_link(context, name, length, &stats);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sends a dump request and feeds every message of the answer to a handler. Called with netlink_lock held.
+ *
+ * @param request The request; its sequence number is assigned here.
+ * @param interrupted Pointer set to true if the kernel flagged the dump as inconsistent (links changed during it).
+ * @return 0 on success, or -1 with errno set.
+ */
+static int run_dump(struct nlmsghdr* request, MessageHandler handler, void* context, bool* interrupted)
+{
+    request->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request->nlmsg_seq = ++sequence;
+    struct sockaddr_nl kernel = {.nl_family = AF_NETLINK};
+    ssize_t sent;
+    do
+    {
+        sent = sendto(netlink_socket, request, request->nlmsg_len, 0, (struct sockaddr*)&kernel, sizeof(kernel));
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)request->nlmsg_len)
+    {
+        return -1;
+    }
+
+    while (true)
+    {
+        ssize_t received = recv(netlink_socket, receive_buffer, NETLINK_RECEIVE_SIZE, 0);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        int remaining = (int)received;
+        for (const struct nlmsghdr* header = (const struct nlmsghdr*)receive_buffer; NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining))
+        {
+            if (header->nlmsg_seq != sequence)
+            {
+                continue; // Left over from a dump abandoned after an error
+            }
+            if (header->nlmsg_flags & NLM_F_DUMP_INTR)
+            {
+                *interrupted = true;
+            }
+            if (header->nlmsg_type == NLMSG_DONE)
+            {
+                return 0;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR)
+            {
+                const struct nlmsgerr* error = NLMSG_DATA(header);
+                errno = error->error != 0 ? -error->error : EPROTO;
+                return -1;
+            }
+            if (!handler(header, context))
+            {
+                return -1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Dumps every link, either for its name only or for its name and IFLA_STATS64.
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+static int dump_links(MessageHandler handler, void* context, bool with_stats, bool* interrupted)
+{
+    struct
+    {
+        struct nlmsghdr header;
+        struct ifinfomsg info;
+        struct rtattr mask_attribute;
+        unsigned int mask;
+    } request = {0};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.info.ifi_family = AF_UNSPEC;
+    if (!with_stats)
+    {
+        request.header.nlmsg_len += RTA_SPACE(sizeof(unsigned int));
+        request.mask_attribute.rta_type = IFLA_EXT_MASK;
+        request.mask_attribute.rta_len = RTA_LENGTH(sizeof(unsigned int));
+        request.mask = RTEXT_FILTER_SKIP_STATS;
+    }
+    return run_dump(&request.header, handler, context, interrupted);
+}
+
+/**
+ * @brief Resynchronizes the name table with a link dump without statistics. Called with netlink_lock held.
+ *
+ * Links missing from the dump were deleted since the table was last current, and are reported as removed.
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+static int refresh_link_names(void)
+{
+    for (size_t i = 0; i < link_names_size; i++)
+    {
+        link_names[i].seen = false;
+    }
+
+    bool interrupted = false;
+    if (dump_links(handle_name, NULL, false, &interrupted) != 0)
+    {
+        resync_pending = true;
+        return -1;
+    }
+    resync_pending = interrupted;
+
+    for (size_t i = 0; i < link_names_size;)
+    {
+        if (link_names[i].index != 0 && !link_names[i].seen)
+        {
+            report_removed(link_names[i].name);
+            remove_link_name(&link_names[i]); // May shift a later entry into this slot: look at it again
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Collects counters with one RTM_GETSTATS dump, refreshing the names once if a link is new.
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+static int collect_stats(DumpTarget* target, bool* interrupted)
+{
+    struct
+    {
+        struct nlmsghdr header;
+        struct if_stats_msg message;
+    } request = {0};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct if_stats_msg));
+    request.header.nlmsg_type = RTM_GETSTATS;
+    request.message.family = AF_UNSPEC;
+    request.message.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    if ((link_name_count == 0 || resync_pending) && refresh_link_names() != 0)
+    {
+        return -1;
+    }
+    if (run_dump(&request.header, handle_stats, target, interrupted) != 0)
+    {
+        return -1;
+    }
+    if (target->unknown_link)
+    {
+        target->count = 0;
+        target->unknown_link = false;
+        if (refresh_link_names() != 0 || run_dump(&request.header, handle_stats, target, interrupted) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int netlink_stats_init(void)
+{
+    pthread_mutex_lock(&netlink_lock);
+    if (receive_buffer == NULL)
+    {
+        receive_buffer = malloc(NETLINK_RECEIVE_SIZE);
+    }
+    if (netlink_socket < 0 && receive_buffer != NULL)
+    {
+        netlink_socket = open_socket(0);
+    }
+    bool opened = netlink_socket >= 0;
+    pthread_mutex_unlock(&netlink_lock);
+
+    atomic_store(&enabled, opened);
+    return opened ? 0 : -1;
+}
+
+bool netlink_stats_enabled(void)
+{
+    return atomic_load(&enabled);
+}
+
+ssize_t netlink_stats_read(InterfaceStats** interfaces, size_t* capacity)
+{
+    pthread_mutex_lock(&netlink_lock);
+    if (netlink_socket < 0 && receive_buffer != NULL)
+    {
+        netlink_socket = open_socket(0);
+    }
+
+    ssize_t count = -1;
+    for (int attempt = 0; netlink_socket >= 0 && attempt <= NETLINK_DUMP_RETRIES; attempt++)
+    {
+        DumpTarget target = {interfaces, capacity, 0, false};
+        bool interrupted = false;
+        int result = stats_dump_supported ? collect_stats(&target, &interrupted)
+                                          : dump_links(handle_link, &target, true, &interrupted);
+        if (result != 0 && stats_dump_supported && (errno == EOPNOTSUPP || errno == EINVAL))
+        {
+            // Kernels before 4.7 have no RTM_GETSTATS; full link dumps carry the same counters, only more slowly
+            stats_dump_supported = false;
+            attempt--;
+            continue;
+        }
+        if (result != 0)
+        {
+            // The rest of the dump may still be queued (or was lost on ENOBUFS): start over on a fresh socket
+            LOG_MESSAGE("Netlink dump failed (%s), reading /proc/net/dev\n", strerror(errno));
+            close(netlink_socket);
+            netlink_socket = -1;
+            break;
+        }
+        count = (ssize_t)target.count;
+        if (!interrupted)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&netlink_lock);
+
+    return count;
+}
+
+int netlink_stats_watch(LinkRemovedHandler handler)
+{
+    pthread_mutex_lock(&netlink_lock);
+    if (receive_buffer == NULL)
+    {
+        receive_buffer = malloc(NETLINK_RECEIVE_SIZE);
+    }
+    if (netlink_socket < 0 && receive_buffer != NULL)
+    {
+        netlink_socket = open_socket(0);
+    }
+    if (event_socket < 0 && netlink_socket >= 0)
+    {
+        event_socket = open_socket(RTMGRP_LINK);
+    }
+
+    // Subscribed before the dump, so a link deleted meanwhile is either missing from it or notified afterwards
+    removed_handler = handler;
+    int result = event_socket >= 0 ? refresh_link_names() : -1;
+    if (result != 0 && event_socket >= 0)
+    {
+        close(event_socket);
+        event_socket = -1;
+    }
+    if (result != 0)
+    {
+        removed_handler = NULL;
+    }
+    pthread_mutex_unlock(&netlink_lock);
+
+    return result;
+}
+
+void netlink_stats_poll(void)
+{
+    pthread_mutex_lock(&netlink_lock);
+    while (event_socket >= 0)
+    {
+        ssize_t received = recv(event_socket, receive_buffer, NETLINK_RECEIVE_SIZE, 0);
+        if (received < 0)
+        {
+            if (errno == ENOBUFS)
+            {
+                resync_pending = true; // The kernel dropped notifications; the socket stays usable
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break; // EAGAIN: every pending notification is handled
+        }
+
+        int remaining = (int)received;
+        for (const struct nlmsghdr* header = (const struct nlmsghdr*)receive_buffer; NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining))
+        {
+            if (!handle_name(header, NULL))
+            {
+                resync_pending = true;
+            }
+        }
+    }
+
+    if (event_socket >= 0 && resync_pending)
+    {
+        if (netlink_socket < 0)
+        {
+            netlink_socket = open_socket(0);
+        }
+        if (netlink_socket >= 0 && refresh_link_names() != 0)
+        {
+            close(netlink_socket); // The rest of the dump may still be queued; retried on the next poll
+            netlink_socket = -1;
+        }
+    }
+    pthread_mutex_unlock(&netlink_lock);
+}
+
+void netlink_stats_close(void)
+{
+    atomic_store(&enabled, false);
+    pthread_mutex_lock(&netlink_lock);
+    if (netlink_socket >= 0)
+    {
+        close(netlink_socket);
+        netlink_socket = -1;
+    }
+    if (event_socket >= 0)
+    {
+        close(event_socket);
+        event_socket = -1;
+    }
+    removed_handler = NULL;
+    resync_pending = false;
+    free(receive_buffer);
+    receive_buffer = NULL;
+    free(link_names);
+    link_names = NULL;
+    link_names_size = link_name_count = 0;
+    pthread_mutex_unlock(&netlink_lock);
+}
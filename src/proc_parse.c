@@ -0,0 +1,124 @@
+/**
+ * @file proc_parse.c
+ * @brief Allocation-free parsers for procfs/sysfs text.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "proc_parse.h"
+#include <string.h>
+
+const char* parse_next_line(const char** cursor, size_t* length)
+{
+    const char* line = *cursor;
+    if (line == NULL || *line == '\0')
+    {
+        return NULL;
+    }
+
+    const char* newline = strchr(line, '\n');
+    if (newline != NULL)
+    {
+        *length = (size_t)(newline - line);
+        *cursor = newline + 1;
+    }
+    else
+    {
+        *length = strlen(line);
+        *cursor = NULL;
+    }
+    return line;
+}
+
+const char* parse_skip_spaces(const char* text)
+{
+    while (*text == ' ' || *text == '\t')
+    {
+        text++;
+    }
+    return text;
+}
+
+const char* parse_u64(const char* text, unsigned long long* value)
+{
+    text = parse_skip_spaces(text);
+    if (*text < '0' || *text > '9')
+    {
+        return NULL;
+    }
+
+    unsigned long long result = 0;
+    while (*text >= '0' && *text <= '9')
+    {
+        result = result * 10 + (unsigned long long)(*text - '0');
+        text++;
+    }
+    *value = result;
+    return text;
+}
+
+const char* parse_s64(const char* text, long long* value)
+{
+    text = parse_skip_spaces(text);
+    bool negative = *text == '-';
+    if (negative || *text == '+')
+    {
+        text++;
+    }
+
+    unsigned long long magnitude;
+    text = parse_u64(text, &magnitude);
+    if (text == NULL)
+    {
+        return NULL;
+    }
+    *value = negative ? -(long long)magnitude : (long long)magnitude;
+    return text;
+}
+
+const char* parse_skip_fields(const char* text, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        text = parse_skip_spaces(text);
+        if (*text == '\0' || *text == '\n')
+        {
+            return NULL;
+        }
+        while (*text != ' ' && *text != '\t' && *text != '\n' && *text != '\0')
+        {
+            text++;
+        }
+    }
+    return text;
+}
+
+const char* parse_key(const char* line, size_t length, char delimiter, ParseKey* key)
+{
+    const char* end = line + length;
+    while (line < end && (*line == ' ' || *line == '\t'))
+    {
+        line++;
+    }
+
+    const char* found = memchr(line, delimiter, (size_t)(end - line));
+    if (found == NULL)
+    {
+        return NULL;
+    }
+
+    const char* key_end = found;
+    while (key_end > line && (key_end[-1] == ' ' || key_end[-1] == '\t'))
+    {
+        key_end--;
+    }
+    key->name = line;
+    key->length = (size_t)(key_end - line);
+    key->hash = parse_hash(line, key->length);
+    return found + 1;
+}
+
+bool parse_key_equals(const ParseKey* a, const ParseKey* b)
+{
+    return a->hash == b->hash && a->length == b->length && memcmp(a->name, b->name, a->length) == 0;
+}
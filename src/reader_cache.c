@@ -0,0 +1,413 @@
+/**
+ * @file reader_cache.c
+ * @brief Cached procfs/sysfs reader built on persistent descriptors and pread().
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "reader_cache.h"
+#include "batch_reader.h"
+#include "capture.h"
+#include "proc_parse.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define READER_GROW_SIZE 4096 /**< Initial size and minimum headroom of growable buffers. */
+
+/**
+ * @brief Structure to hold one cached file descriptor.
+ */
+typedef struct
+{
+    char path[READER_PATH_SIZE]; /**< Path the descriptor was opened from. */
+    unsigned int hash;           /**< Hash of path, compared before the string. */
+    int fd;                      /**< Open descriptor, or -1 after a failed reopen. */
+    pthread_mutex_t lock;        /**< Serializes reads and reopens of this entry. */
+} ReaderEntry;
+
+static ReaderEntry entries[READER_CACHE_SIZE];                 /**< Cached descriptors. */
+static size_t entry_count = 0;                                 /**< Number of used entries. */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects entries and entry_count. */
+static atomic_ullong syscalls_saved = 0;                       /**< open()/close() calls avoided so far. */
+static char proc_root[READER_ROOT_SIZE];                       /**< Directory standing in for /proc, or empty. */
+static char sys_root[READER_ROOT_SIZE];                        /**< Directory standing in for /sys, or empty. */
+
+/**
+ * @brief Copies a root, dropping trailing slashes so that "<root>" + "/stat" stays a clean path.
+ */
+static int set_root(char* root, const char* value)
+{
+    size_t length = value != NULL ? strlen(value) : 0;
+    while (length > 1 && value[length - 1] == '/')
+    {
+        length--;
+    }
+    if (length >= READER_ROOT_SIZE)
+    {
+        return -1;
+    }
+    memcpy(root, value != NULL ? value : "", length);
+    root[length] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Checks whether a path lies under a top-level directory, e.g. "/proc".
+ *
+ * @return The length of the directory prefix, or 0 if the path is not under it.
+ */
+static size_t under(const char* path, const char* directory)
+{
+    size_t length = strlen(directory);
+    return strncmp(path, directory, length) == 0 && (path[length] == '/' || path[length] == '\0') ? length : 0;
+}
+
+/**
+ * @brief Reads a descriptor from offset 0 until end of file.
+ *
+ * @param fd The descriptor to read.
+ * @param buffer Pointer to the destination buffer.
+ * @param capacity Pointer to the size of the buffer.
+ * @param growable Whether the buffer is heap-allocated and may be reallocated.
+ * @return The number of bytes read (the buffer is NUL-terminated), or -1 in case of error.
+ */
+static ssize_t pread_file(int fd, char** buffer, size_t* capacity, bool growable)
+{
+    size_t length = 0;
+    while (true)
+    {
+        if (growable && *capacity - length < READER_GROW_SIZE)
+        {
+            size_t new_capacity = *capacity > 0 ? *capacity * 2 : READER_GROW_SIZE;
+            char* grown = realloc(*buffer, new_capacity);
+            if (grown == NULL)
+            {
+                errno = ENOMEM;
+                return -1;
+            }
+            *buffer = grown;
+            *capacity = new_capacity;
+        }
+        if (length + 1 >= *capacity)
+        {
+            break;
+        }
+
+        ssize_t n = pread(fd, *buffer + length, *capacity - length - 1, (off_t)length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        length += (size_t)n;
+    }
+
+    (*buffer)[length] = '\0';
+    return (ssize_t)length;
+}
+
+/**
+ * @brief Finds the cache entry for a path, opening and inserting it if needed.
+ *
+ * @param path The path to look up.
+ * @return The entry, locked and with an open descriptor, or NULL in case of error. errno is ENOSPC when the cache is
+ * full.
+ */
+static ReaderEntry* acquire_entry(const char* path)
+{
+    if (strlen(path) >= READER_PATH_SIZE)
+    {
+        errno = ENOSPC;
+        return NULL;
+    }
+
+    unsigned int hash = parse_hash(path, strlen(path));
+    ReaderEntry* entry = NULL;
+
+    pthread_mutex_lock(&cache_lock);
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (entries[i].hash == hash && strcmp(entries[i].path, path) == 0)
+        {
+            entry = &entries[i];
+            break;
+        }
+    }
+    if (entry == NULL)
+    {
+        if (entry_count == READER_CACHE_SIZE)
+        {
+            pthread_mutex_unlock(&cache_lock);
+            errno = ENOSPC;
+            return NULL;
+        }
+
+        int fd = reader_open(path);
+        if (fd < 0)
+        {
+            int saved_errno = errno;
+            pthread_mutex_unlock(&cache_lock);
+            errno = saved_errno;
+            return NULL;
+        }
+
+        entry = &entries[entry_count];
+        strcpy(entry->path, path);
+        entry->hash = hash;
+        entry->fd = fd;
+        pthread_mutex_init(&entry->lock, NULL);
+        entry_count++;
+        pthread_mutex_lock(&entry->lock);
+        pthread_mutex_unlock(&cache_lock);
+        return entry;
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    pthread_mutex_lock(&entry->lock);
+    if (entry->fd < 0)
+    {
+        entry->fd = reader_open(path);
+        if (entry->fd < 0)
+        {
+            int saved_errno = errno;
+            pthread_mutex_unlock(&entry->lock);
+            errno = saved_errno;
+            return NULL;
+        }
+    }
+    else
+    {
+        atomic_fetch_add_explicit(&syscalls_saved, 2, memory_order_relaxed);
+    }
+    return entry;
+}
+
+/**
+ * @brief Reads a file through the cache, falling back to a transient read when the cache is full.
+ */
+static ssize_t read_through_cache(const char* path, char** buffer, size_t* capacity, bool growable)
+{
+    ssize_t prefetched = batch_reader_take(path, buffer, capacity, growable);
+    if (prefetched >= 0)
+    {
+        return prefetched;
+    }
+
+    ReaderEntry* entry = acquire_entry(path);
+    if (entry == NULL)
+    {
+        if (errno != ENOSPC)
+        {
+            return -1;
+        }
+
+        int fd = reader_open(path);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        ssize_t n = pread_file(fd, buffer, capacity, growable);
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return n;
+    }
+
+    ssize_t n = pread_file(entry->fd, buffer, capacity, growable);
+    if (n < 0 && (errno == ENODEV || errno == ENOENT || errno == ESTALE))
+    {
+        // The file behind the descriptor went away; reopen by path in case it was re-registered.
+        close(entry->fd);
+        entry->fd = reader_open(path);
+        if (entry->fd >= 0)
+        {
+            n = pread_file(entry->fd, buffer, capacity, growable);
+        }
+    }
+
+    int saved_errno = errno;
+    pthread_mutex_unlock(&entry->lock);
+    errno = saved_errno;
+    return n;
+}
+
+int reader_set_roots(const char* proc, const char* sys)
+{
+    return set_root(proc_root, proc) == 0 && set_root(sys_root, sys) == 0 ? 0 : -1;
+}
+
+const char* reader_resolve(const char* path, char* buffer, size_t size)
+{
+    size_t prefix;
+    const char* root;
+    if (proc_root[0] != '\0' && (prefix = under(path, "/proc")) > 0)
+    {
+        root = proc_root;
+    }
+    else if (sys_root[0] != '\0' && (prefix = under(path, "/sys")) > 0)
+    {
+        root = sys_root;
+    }
+    else
+    {
+        return path;
+    }
+
+    int length = snprintf(buffer, size, "%s%s", root, path + prefix);
+    return length >= 0 && (size_t)length < size ? buffer : NULL;
+}
+
+int reader_open(const char* path)
+{
+    char resolved[READER_ROOT_SIZE + READER_PATH_SIZE];
+    const char* target = reader_resolve(path, resolved, sizeof(resolved));
+    if (target == NULL)
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return open(target, O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * @brief Reads a file through the cache, or from the capture being replayed, recording what was read if requested.
+ */
+static ssize_t cached_read(const char* path, char** buffer, size_t* capacity, bool growable)
+{
+    if (capture_replaying())
+    {
+        return capture_replay_read(path, buffer, capacity, growable);
+    }
+    ssize_t n = read_through_cache(path, buffer, capacity, growable);
+    capture_record_read(path, *buffer, n);
+    return n;
+}
+
+ssize_t reader_read(const char* path, char* buffer, size_t size)
+{
+    return cached_read(path, &buffer, &size, false);
+}
+
+ssize_t reader_read_all(const char* path, char** buffer, size_t* capacity)
+{
+    return cached_read(path, buffer, capacity, true);
+}
+
+ssize_t reader_read_transient(const char* path, char* buffer, size_t size)
+{
+    if (capture_replaying())
+    {
+        return capture_replay_read(path, &buffer, &size, false);
+    }
+
+    ssize_t n = -1;
+    int fd = reader_open(path);
+    if (fd >= 0)
+    {
+        n = pread_file(fd, &buffer, &size, false);
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+    }
+    capture_record_read(path, buffer, n);
+    return n;
+}
+
+ssize_t reader_read_directory(const char* path, char** buffer, size_t* capacity)
+{
+    if (capture_replaying())
+    {
+        return capture_replay_read(path, buffer, capacity, true);
+    }
+
+    char resolved[READER_ROOT_SIZE + READER_PATH_SIZE];
+    const char* target = reader_resolve(path, resolved, sizeof(resolved));
+    DIR* directory = target != NULL ? opendir(target) : NULL;
+    if (directory == NULL)
+    {
+        capture_record_read(path, NULL, -1);
+        return -1;
+    }
+
+    size_t length = 0;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        size_t name_length = strlen(entry->d_name);
+        if (*capacity < length + name_length + 2)
+        {
+            size_t new_capacity = *capacity > 0 ? *capacity : READER_GROW_SIZE;
+            while (new_capacity < length + name_length + 2)
+            {
+                new_capacity *= 2;
+            }
+            char* grown = realloc(*buffer, new_capacity);
+            if (grown == NULL)
+            {
+                closedir(directory);
+                errno = ENOMEM;
+                return -1;
+            }
+            *buffer = grown;
+            *capacity = new_capacity;
+        }
+        memcpy(*buffer + length, entry->d_name, name_length);
+        (*buffer)[length + name_length] = '\n';
+        length += name_length + 1;
+    }
+    closedir(directory);
+
+    if (*capacity == 0)
+    {
+        char* allocated = malloc(1);
+        if (allocated == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        *buffer = allocated;
+        *capacity = 1;
+    }
+    (*buffer)[length] = '\0';
+    capture_record_read(path, *buffer, (ssize_t)length);
+    return (ssize_t)length;
+}
+
+unsigned long long reader_syscalls_saved(void)
+{
+    return atomic_load_explicit(&syscalls_saved, memory_order_relaxed);
+}
+
+void reader_close_all(void)
+{
+    pthread_mutex_lock(&cache_lock);
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        pthread_mutex_lock(&entries[i].lock);
+        if (entries[i].fd >= 0)
+        {
+            close(entries[i].fd);
+            entries[i].fd = -1;
+        }
+        pthread_mutex_unlock(&entries[i].lock);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file sample_ring.c
+ * @brief Fixed-size single-producer/single-consumer sample rings and their window aggregates.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "sample_ring.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const double sample_quantiles[SAMPLE_QUANTILE_COUNT] = {0.5, 0.9, 0.99};
+
+static int compare_samples(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void sample_ring_push(SampleRing* ring, double value)
+{
+    unsigned long long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->values[head % SAMPLE_RING_SIZE] = value;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+bool sample_ring_drain(SampleRing* ring, SampleWindow* window)
+{
+    double samples[SAMPLE_RING_SIZE];
+    unsigned long long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned long long first = ring->tail;
+    if (head - first > SAMPLE_RING_SIZE)
+    {
+        first = head - SAMPLE_RING_SIZE; // The scrape came late; the oldest samples are gone
+    }
+
+    size_t count = 0;
+    for (unsigned long long seq = first; seq < head; seq++)
+    {
+        samples[count++] = ring->values[seq % SAMPLE_RING_SIZE];
+    }
+    ring->tail = head;
+
+    // The slot of sequence s is rewritten while head is s + SAMPLE_RING_SIZE, so drop what the producer lapped
+    atomic_thread_fence(memory_order_acquire);
+    unsigned long long after = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (after + 1 > first + SAMPLE_RING_SIZE)
+    {
+        size_t lapped = (size_t)(after + 1 - SAMPLE_RING_SIZE - first);
+        lapped = lapped < count ? lapped : count;
+        count -= lapped;
+        memmove(samples, samples + lapped, count * sizeof(double));
+    }
+    if (count == 0)
+    {
+        return false;
+    }
+
+    double sum = 0;
+    qsort(samples, count, sizeof(double), compare_samples);
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+    window->count = count;
+    window->min = samples[0];
+    window->max = samples[count - 1];
+    window->avg = sum / (double)count;
+    for (size_t q = 0; q < SAMPLE_QUANTILE_COUNT; q++)
+    {
+        size_t rank = (size_t)ceil(sample_quantiles[q] * (double)count);
+        window->quantiles[q] = samples[rank > 0 ? rank - 1 : 0];
+    }
+    return true;
+}
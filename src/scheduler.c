@@ -0,0 +1,278 @@
+/**
+ * @file scheduler.c
+ * @brief Hierarchical timer wheel and the collector group scheduler built on it.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "scheduler.h"
+#include "batch_reader.h"
+#include "worker_pool.h"
+
+/**
+ * @brief Structure to hold the scheduling state of one collector group.
+ */
+typedef struct
+{
+    WheelTimer timer;               /**< Timer armed for the next deadline. */
+    CollectorGroup* group;          /**< The group to run. */
+    unsigned long long deadline_ms; /**< Next absolute deadline, in ms since the scheduler started. */
+} ScheduledGroup;
+
+void wheel_init(TimerWheel* wheel, unsigned long long now)
+{
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+    wheel->now = now;
+}
+
+void wheel_add(TimerWheel* wheel, WheelTimer* timer)
+{
+    if (timer->expires < wheel->now)
+    {
+        timer->expires = wheel->now;
+    }
+
+    unsigned long long delta = timer->expires - wheel->now;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ULL << (WHEEL_SLOT_BITS * (level + 1))))
+    {
+        level++;
+    }
+    if (delta >= (1ULL << (WHEEL_SLOT_BITS * WHEEL_LEVELS)))
+    {
+        // Beyond the span of the top level; clamp, the owner re-arms on expiry anyway
+        timer->expires = wheel->now + (1ULL << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1;
+    }
+
+    size_t slot = (timer->expires >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK;
+    timer->next = wheel->slots[level][slot];
+    wheel->slots[level][slot] = timer;
+}
+
+/**
+ * @brief Moves every timer of a higher-level slot into the levels below it.
+ */
+static void wheel_cascade(TimerWheel* wheel, int level)
+{
+    size_t slot = (wheel->now >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK;
+    WheelTimer* timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+
+    while (timer != NULL)
+    {
+        WheelTimer* next = timer->next;
+        wheel_add(wheel, timer);
+        timer = next;
+    }
+}
+
+WheelTimer* wheel_advance(TimerWheel* wheel, unsigned long long target)
+{
+    WheelTimer* expired = NULL;
+
+    while (wheel->now <= target)
+    {
+        size_t slot = wheel->now & WHEEL_SLOT_MASK;
+        if (slot == 0)
+        {
+            for (int level = 1; level < WHEEL_LEVELS; level++)
+            {
+                wheel_cascade(wheel, level);
+                if (((wheel->now >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK) != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        WheelTimer* timer = wheel->slots[0][slot];
+        wheel->slots[0][slot] = NULL;
+        while (timer != NULL)
+        {
+            WheelTimer* next = timer->next;
+            timer->next = expired;
+            expired = timer;
+            timer = next;
+        }
+
+        if (wheel->now == target)
+        {
+            break;
+        }
+        wheel->now++;
+    }
+
+    return expired;
+}
+
+unsigned long long wheel_next_expiry(const TimerWheel* wheel)
+{
+    unsigned long long boundary = (wheel->now | WHEEL_SLOT_MASK) + 1;
+    for (unsigned long long tick = wheel->now + 1; tick < boundary; tick++)
+    {
+        if (wheel->slots[0][tick & WHEEL_SLOT_MASK] != NULL)
+        {
+            return tick;
+        }
+    }
+    return boundary;
+}
+
+/**
+ * @brief Retrieves the time elapsed on CLOCK_MONOTONIC since a reference point, in milliseconds.
+ */
+static unsigned long long elapsed_ms(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ms = (long long)(now.tv_sec - start->tv_sec) * 1000LL + (now.tv_nsec - start->tv_nsec) / 1000000L;
+    return ms > 0 ? (unsigned long long)ms : 0;
+}
+
+/**
+ * @brief Converts an offset in milliseconds from a reference point to an absolute CLOCK_MONOTONIC time.
+ */
+static struct timespec offset_to_timespec(const struct timespec* start, unsigned long long offset_ms)
+{
+    struct timespec time = *start;
+    time.tv_sec += (time_t)(offset_ms / 1000ULL);
+    time.tv_nsec += (long)(offset_ms % 1000ULL) * 1000000L;
+    if (time.tv_nsec >= 1000000000L)
+    {
+        time.tv_sec++;
+        time.tv_nsec -= 1000000000L;
+    }
+    return time;
+}
+
+/**
+ * @brief Sleeps until an absolute time on CLOCK_MONOTONIC.
+ *
+ * Sleeping to an absolute deadline rather than for a duration keeps the time spent collecting and the wakeup latency
+ * of one tick from shifting every later tick.
+ *
+ * @return How late the wakeup was, in seconds.
+ */
+static double sleep_until(const struct timespec* deadline)
+{
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) == EINTR)
+    {
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double lateness = (double)(now.tv_sec - deadline->tv_sec) + (double)(now.tv_nsec - deadline->tv_nsec) / 1e9;
+    return lateness > 0 ? lateness : 0;
+}
+
+/**
+ * @brief Reads the procfs files of the groups due in this tick in one batch, if the batch reader is enabled.
+ *
+ * Groups that may block are left out; their reads stay on their sacrificial threads.
+ */
+static void prefetch_group_files(CollectorGroup* groups[], size_t num_groups)
+{
+    const char* paths[GROUP_COUNT * GROUP_MAX_FILES];
+    size_t num_paths = 0;
+
+    if (!batch_reader_enabled())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < num_groups; i++)
+    {
+        for (size_t j = 0; j < GROUP_MAX_FILES && groups[i]->files[j] != NULL && !groups[i]->may_block; j++)
+        {
+            paths[num_paths++] = groups[i]->files[j];
+        }
+    }
+    batch_reader_prefetch(paths, num_paths);
+}
+
+/**
+ * @brief Converts an absolute deadline in milliseconds to the wheel tick it falls in, rounding up.
+ */
+static unsigned long long deadline_to_tick(unsigned long long deadline_ms)
+{
+    return (deadline_ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+}
+
+void scheduler_run(CollectorGroup* groups[], size_t num_groups)
+{
+    ScheduledGroup scheduled[GROUP_COUNT];
+    TimerWheel wheel;
+    struct timespec start;
+
+    if (num_groups > GROUP_COUNT)
+    {
+        num_groups = GROUP_COUNT;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    wheel_init(&wheel, 0);
+
+    metrics_begin_tick();
+    prefetch_group_files(groups, num_groups);
+    for (size_t i = 0; i < num_groups; i++)
+    {
+        scheduled[i].group = groups[i];
+        scheduled[i].deadline_ms = get_group_interval(groups[i]);
+
+        // A run has to finish before the next one is due
+        struct timespec run_deadline = offset_to_timespec(&start, scheduled[i].deadline_ms);
+        worker_pool_submit(groups[i], &run_deadline);
+
+        scheduled[i].timer.data = &scheduled[i];
+        scheduled[i].timer.expires = deadline_to_tick(scheduled[i].deadline_ms);
+        wheel_add(&wheel, &scheduled[i].timer);
+    }
+
+    while (true)
+    {
+        struct timespec tick_time = offset_to_timespec(&start, wheel_next_expiry(&wheel) * WHEEL_TICK_MS);
+        double lateness = sleep_until(&tick_time);
+
+        unsigned long long now_ms = elapsed_ms(&start);
+        WheelTimer* expired = wheel_advance(&wheel, now_ms / WHEEL_TICK_MS);
+        if (expired == NULL)
+        {
+            continue; // Cascade point of the wheel, nothing to collect
+        }
+        record_tick_lateness(lateness);
+
+        // Groups due in the same wheel tick share one set of procfs snapshots
+        CollectorGroup* due[GROUP_COUNT];
+        size_t num_due = 0;
+        for (WheelTimer* timer = expired; timer != NULL && num_due < GROUP_COUNT; timer = timer->next)
+        {
+            due[num_due++] = ((ScheduledGroup*)timer->data)->group;
+        }
+        metrics_begin_tick();
+        prefetch_group_files(due, num_due);
+        while (expired != NULL)
+        {
+            WheelTimer* next = expired->next;
+            ScheduledGroup* entry = expired->data;
+
+            // Adaptive groups pick up the interval derived from their last run here
+            unsigned int interval_ms = get_group_interval(entry->group);
+            struct timespec run_deadline = offset_to_timespec(&start, entry->deadline_ms + interval_ms);
+            worker_pool_submit(entry->group, &run_deadline);
+
+            entry->deadline_ms += interval_ms;
+            if (entry->deadline_ms <= now_ms)
+            {
+                // Skip the runs that were missed instead of bursting to catch up
+                unsigned long long missed = (now_ms - entry->deadline_ms) / interval_ms + 1;
+                entry->deadline_ms += missed * interval_ms;
+                record_tick_overrun(entry->group, missed);
+            }
+            entry->timer.expires = deadline_to_tick(entry->deadline_ms);
+            wheel_add(&wheel, &entry->timer);
+
+            expired = next;
+        }
+        govern_cpu_budget();
+    }
+}
@@ -0,0 +1,391 @@
+/**
+ * @file worker_pool.c
+ * @brief Fixed-size worker pool running collector groups by priority.
+ * @author 1v6n
+ * @date 16/10/2026
+ */
+
+#include "worker_pool.h"
+#include <errno.h>
+#include <stdatomic.h>
+
+/**
+ * @brief Structure to hold a queued or running collector group run.
+ *
+ * There is one job per group, so submitting never allocates.
+ */
+typedef struct PoolJob
+{
+    struct PoolJob* next;     /**< Next job in the same priority queue. */
+    CollectorGroup* group;    /**< The group to run. */
+    struct timespec deadline; /**< Time by which the run should have finished. */
+    bool pending;             /**< Whether the job is queued or running. */
+    bool hung;                /**< Whether an abandoned run of the group is still stuck in the kernel. */
+    unsigned int failures;    /**< Consecutive failed or timed out runs, drives the backoff. */
+    struct timespec retry_at; /**< Runs submitted before this time are skipped while backing off. */
+} PoolJob;
+
+/**
+ * @brief Structure to hold a run of a blocking group on its sacrificial thread.
+ *
+ * Shared by the worker waiting for the run and the thread executing it; whichever lets go last frees it.
+ */
+typedef struct
+{
+    PoolJob* job;             /**< The job being run. */
+    pthread_mutex_t lock;     /**< Protects done and refs. */
+    pthread_cond_t done_cond; /**< Signaled when the update function returns. */
+    bool done;                /**< Whether the update function returned. */
+    int status;               /**< Return value of the update function once done. */
+    atomic_bool abandoned;    /**< Set when the worker gave up waiting; late results are discarded. */
+    int refs;                 /**< Number of threads still holding the run. */
+} BlockingRun;
+
+/**
+ * @brief Structure to hold a FIFO queue of jobs.
+ */
+typedef struct
+{
+    PoolJob* head; /**< Oldest job. */
+    PoolJob* tail; /**< Newest job. */
+} JobQueue;
+
+static PoolJob jobs[GROUP_COUNT];                             /**< One job slot per collector group. */
+static JobQueue queues[PRIORITY_COUNT];                       /**< Queued jobs, one queue per priority. */
+static pthread_t workers[WORKER_POOL_MAX_SIZE];               /**< Worker threads. */
+static size_t worker_count = 0;                               /**< Number of started worker threads. */
+static bool stopping = false;                                 /**< Set when the pool is shutting down. */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protects jobs, queues and stopping. */
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;   /**< Signaled when a job is queued or on stop. */
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;   /**< Broadcast when a job finishes or on stop. */
+static unsigned int collector_timeout_ms = WORKER_POOL_DEFAULT_TIMEOUT_MS; /**< Deadline of blocking group runs. */
+
+static _Thread_local BlockingRun* current_run = NULL; /**< Run executed by this sacrificial thread, if any. */
+
+/**
+ * @brief Removes the oldest job of the highest non-empty priority. Called with pool_lock held.
+ */
+static PoolJob* dequeue_job(void)
+{
+    for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        PoolJob* job = queues[priority].head;
+        if (job != NULL)
+        {
+            queues[priority].head = job->next;
+            if (queues[priority].head == NULL)
+            {
+                queues[priority].tail = NULL;
+            }
+            job->next = NULL;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Retrieves the seconds elapsed between two CLOCK_MONOTONIC times.
+ */
+static double seconds_between(const struct timespec* from, const struct timespec* to)
+{
+    return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Retrieves the CLOCK_MONOTONIC time a number of milliseconds from now.
+ */
+static struct timespec time_after_ms(unsigned long long ms)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    time.tv_sec += (time_t)(ms / 1000ULL);
+    time.tv_nsec += (long)(ms % 1000ULL) * 1000000L;
+    if (time.tv_nsec >= 1000000000L)
+    {
+        time.tv_sec++;
+        time.tv_nsec -= 1000000000L;
+    }
+    return time;
+}
+
+/**
+ * @brief Drops one reference to a blocking run, freeing it with the last one. Called with run->lock held.
+ */
+static void release_run(BlockingRun* run)
+{
+    bool last = --run->refs == 0;
+    pthread_mutex_unlock(&run->lock);
+    if (last)
+    {
+        pthread_cond_destroy(&run->done_cond);
+        pthread_mutex_destroy(&run->lock);
+        free(run);
+    }
+}
+
+/**
+ * @brief Sacrificial thread: runs the update function of a blocking group once.
+ */
+static void* blocking_run_main(void* arg)
+{
+    BlockingRun* run = arg;
+    current_run = run;
+    int status = run_collector_group(run->job->group);
+
+    pthread_mutex_lock(&run->lock);
+    run->done = true;
+    run->status = status;
+    pthread_cond_signal(&run->done_cond);
+    if (atomic_load(&run->abandoned))
+    {
+        // The worker moved on; let the group be submitted again now that the kernel call returned
+        pthread_mutex_lock(&pool_lock);
+        run->job->hung = false;
+        pthread_mutex_unlock(&pool_lock);
+    }
+    release_run(run);
+
+    return NULL;
+}
+
+/**
+ * @brief Runs the update function of a blocking group on a sacrificial thread and waits for it up to the timeout.
+ *
+ * If the run does not return in time it is abandoned: its thread is left to finish on its own, whatever it publishes
+ * afterwards is discarded, and the job is marked hung so no second thread piles up behind the same stuck call.
+ *
+ * @param job The job to run.
+ * @param timed_out Pointer set to whether the run was abandoned.
+ * @return The return value of the update function, or -1 if the run was abandoned.
+ */
+static int run_with_timeout(PoolJob* job, bool* timed_out)
+{
+    BlockingRun* run = calloc(1, sizeof(BlockingRun));
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_condattr_t cond_attr;
+
+    *timed_out = false;
+    if (run == NULL)
+    {
+        return run_collector_group(job->group);
+    }
+    run->job = job;
+    run->refs = 2;
+    atomic_init(&run->abandoned, false);
+    pthread_mutex_init(&run->lock, NULL);
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&run->done_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int created = pthread_create(&thread, &attr, blocking_run_main, run);
+    pthread_attr_destroy(&attr);
+    if (created != 0)
+    {
+        // Out of threads; run inline rather than not at all
+        run->refs = 1;
+        pthread_mutex_lock(&run->lock);
+        release_run(run);
+        return run_collector_group(job->group);
+    }
+
+    struct timespec timeout = time_after_ms(collector_timeout_ms);
+    int rc = 0;
+    pthread_mutex_lock(&run->lock);
+    while (!run->done && rc != ETIMEDOUT)
+    {
+        rc = pthread_cond_timedwait(&run->done_cond, &run->lock, &timeout);
+    }
+    int status = run->done ? run->status : RETURN_ERROR;
+    *timed_out = !run->done;
+    if (*timed_out)
+    {
+        atomic_store(&run->abandoned, true);
+        pthread_mutex_lock(&pool_lock);
+        job->hung = true;
+        pthread_mutex_unlock(&pool_lock);
+    }
+    release_run(run);
+
+    return status;
+}
+
+/**
+ * @brief Worker thread: runs queued jobs until the pool stops.
+ */
+static void* worker_main(void* arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&pool_lock);
+    while (true)
+    {
+        PoolJob* job;
+        while (!stopping && (job = dequeue_job()) == NULL)
+        {
+            pthread_cond_wait(&pool_cond, &pool_lock);
+        }
+        if (stopping)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&pool_lock);
+
+        struct timespec started, finished;
+        clock_gettime(CLOCK_MONOTONIC, &started);
+        bool timed_out = false;
+        int status;
+        if (job->group->may_block)
+        {
+            status = run_with_timeout(job, &timed_out);
+        }
+        else
+        {
+            status = run_collector_group(job->group);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &finished);
+
+        if (timed_out)
+        {
+            record_collector_timeout(job->group);
+        }
+        else
+        {
+            bool late = seconds_between(&job->deadline, &finished) > 0;
+            record_collector_run(job->group, seconds_between(&started, &finished), late, status == 0);
+        }
+
+        pthread_mutex_lock(&pool_lock);
+        if (status == 0)
+        {
+            job->failures = 0;
+        }
+        else
+        {
+            // Back off exponentially: 2, 4, 8... intervals in effect (adapted or throttled), capped
+            if (job->failures < WORKER_POOL_MAX_BACKOFF_SHIFT)
+            {
+                job->failures++;
+            }
+            unsigned long long backoff_ms = (unsigned long long)get_group_interval(job->group) << job->failures;
+            if (backoff_ms > WORKER_POOL_MAX_BACKOFF_MS)
+            {
+                backoff_ms = WORKER_POOL_MAX_BACKOFF_MS;
+            }
+            job->retry_at = time_after_ms(backoff_ms);
+        }
+        job->pending = false;
+        pthread_cond_broadcast(&idle_cond);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    return NULL;
+}
+
+int worker_pool_start(size_t num_workers)
+{
+    if (num_workers == 0)
+    {
+        num_workers = 1;
+    }
+    if (num_workers > WORKER_POOL_MAX_SIZE)
+    {
+        num_workers = WORKER_POOL_MAX_SIZE;
+    }
+
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        if (pthread_create(&workers[worker_count], NULL, worker_main, NULL) != 0)
+        {
+            fprintf(stderr, "Error creating collector worker thread\n");
+            break;
+        }
+        worker_count++;
+    }
+
+    return worker_count > 0 ? 0 : RETURN_ERROR;
+}
+
+bool worker_pool_submit(CollectorGroup* group, const struct timespec* deadline)
+{
+    PoolJob* job = &jobs[group - all_groups];
+
+    pthread_mutex_lock(&pool_lock);
+    if (job->failures > 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (seconds_between(&now, &job->retry_at) > 0)
+        {
+            pthread_mutex_unlock(&pool_lock);
+            return false; // Backing off after a failure
+        }
+    }
+    if (job->pending || job->hung || stopping)
+    {
+        pthread_mutex_unlock(&pool_lock);
+        record_collector_skip(group);
+        return false;
+    }
+
+    job->group = group;
+    job->deadline = *deadline;
+    job->pending = true;
+    job->next = NULL;
+
+    JobQueue* queue = &queues[group->priority];
+    if (queue->tail != NULL)
+    {
+        queue->tail->next = job;
+    }
+    else
+    {
+        queue->head = job;
+    }
+    queue->tail = job;
+
+    pthread_cond_signal(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+    return true;
+}
+
+void worker_pool_wait(const CollectorGroup* group)
+{
+    const PoolJob* job = &jobs[group - all_groups];
+
+    pthread_mutex_lock(&pool_lock);
+    while (job->pending && !stopping)
+    {
+        pthread_cond_wait(&idle_cond, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void worker_pool_set_timeout(unsigned int timeout_ms)
+{
+    collector_timeout_ms = timeout_ms > 0 ? timeout_ms : WORKER_POOL_DEFAULT_TIMEOUT_MS;
+}
+
+bool worker_run_abandoned(void)
+{
+    return current_run != NULL && atomic_load(&current_run->abandoned);
+}
+
+void worker_pool_stop(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    stopping = true;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_cond_broadcast(&idle_cond);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    worker_count = 0;
+}